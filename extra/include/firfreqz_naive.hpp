@@ -11,7 +11,7 @@
  * @param magnitudes Output magnitudes for the corresponding frequency
  * @param n     No of values in fresp / mag
  * @param fs    Sample frequency (Hz), used for scaling fresp
- * @param numTamps The number of taps in the filter
+ * @param numTaps The number of taps in the filter
  * @param taps  Array with taps
  * @returns 0 on success, -1 on failure
  */
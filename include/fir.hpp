@@ -1,6 +1,8 @@
 #ifndef FIR_HPP
 #define FIR_HPP
 
+#include <cstddef>
+
 using FirFloat = double;
 
 #define FIR_ENUMTAPS   1
@@ -8,6 +10,35 @@ using FirFloat = double;
 #define FIR_ENUMBANDS  3
 #define FIR_EBANDS     4
 #define FIR_EWEIGHTS   5
+#define FIR_EWORKSPACE 6
+#define FIR_ECONVERGENCE 7
+#define FIR_ESPEC 8
+#define FIR_EWINDOW 9
+#define FIR_EMEMORY 10
+
+/* Solvers of the normal equations reported by firls_stats */
+#define FIR_SOLVER_LEVINSON 1
+#define FIR_SOLVER_LDLT     2
+#define FIR_SOLVER_COD      3
+#define FIR_SOLVER_LU       4
+
+/* Windows for firwin */
+#define FIR_WINDOW_HANN     1
+#define FIR_WINDOW_BLACKMAN 2
+#define FIR_WINDOW_KAISER   3
+
+/* Flag for the frequency response functions: magnitudes in dB */
+#define FIR_FREQZ_DB 1
+
+/* Filtering methods for firfilter_create_method */
+#define FIR_FILTER_AUTO        0
+#define FIR_FILTER_DIRECT      1
+#define FIR_FILTER_FFT         2
+#define FIR_FILTER_PARTITIONED 3
+
+/* Sample layouts for firfilter_multi_create */
+#define FIR_LAYOUT_INTERLEAVED 1
+#define FIR_LAYOUT_PLANAR      2
 
 extern "C" const char *firerror(int errnum);
 
@@ -45,20 +76,687 @@ extern "C" int firls(FirFloat result[], int numTaps, int numBands, const FirFloa
                      const FirFloat desiredBegin[], const FirFloat desiredEnd[],
                      const FirFloat weight[], FirFloat fs);
 
+/**
+ * Single precision version of `firls`. Only the arguments and the result are
+ * float: the design is calculated in double precision.
+ */
+extern "C" int firls_f(float result[], int numTaps, int numBands, const float bands[],
+                       const float desiredBegin[], const float desiredEnd[], const float weight[],
+                       float fs);
+
+/**
+ * Extended precision version of `firls`, the design is calculated in long
+ * double. Long designs with (nearly) rank deficient normal equations are
+ * more accurate, at a higher cost. On platforms where long double is the same
+ * as double, this is the same as `firls`.
+ */
+extern "C" int firls_l(long double result[], int numTaps, int numBands,
+                       const long double bands[], const long double desiredBegin[],
+                       const long double desiredEnd[], const long double weight[],
+                       long double fs);
+
+/**
+ * Same as `firls`, for antisymmetric filters: type III for odd numTaps and
+ * type IV for even numTaps. These have a frequency response
+ *     H(ω) = j e^(-jω(numTaps-1)/2) A(ω)
+ * with a real amplitude A(ω), and `desiredBegin` and `desiredEnd` specify
+ * A(ω). A(ω) is always zero at 0 Hz, and for type III also at nyquist.
+ *
+ * Typical uses are a Hilbert transformer (desired -1 over e.g. 5% to 95% of
+ * nyquist, gives -j) and a differentiator (desired from 0 to π·fmax/nyquist
+ * over a band from 0 to fmax, gives jω).
+ *
+ * @returns 0 on success, error code on failure
+ */
+extern "C" int firls_antisymmetric(FirFloat result[], int numTaps, int numBands,
+                                   const FirFloat bands[], const FirFloat desiredBegin[],
+                                   const FirFloat desiredEnd[], const FirFloat weight[],
+                                   FirFloat fs);
+
+/**
+ * Same as `firls`, with the desired response and the weight given as a
+ * sampled curve, e.g. a measured magnitude response. Both are linear between
+ * the points, and the weight is zero below the first and above the last
+ * point. Repeat a frequency for a discontinuity, e.g. a weight of zero
+ * between two bands.
+ *
+ * The curve is resampled to a uniform grid with at least 16 points per tap,
+ * and the integrals of the normal equations are calculated with a FFT, so the
+ * cost does not depend on the number of points. Discontinuities between grid
+ * points are smoothed over one grid step.
+ *
+ * @param numPoints Number of points of the curve, at least 2
+ * @param frequencies Nondecreasing frequencies of the points in Hz, between 0
+ *      and `fs/2` (inclusive)
+ * @param desired Desired gain at each point
+ * @param weight Non-negative weight at each point
+ * @returns 0 on success, error code on failure. FIR_ESPEC if numPoints is
+ *      less than 2, FIR_EMEMORY if the FFT could not be allocated
+ */
+extern "C" int firls_sampled(FirFloat result[], int numTaps, int numPoints,
+                             const FirFloat frequencies[], const FirFloat desired[],
+                             const FirFloat weight[], FirFloat fs);
+
+/**
+ * Number of threads for large designs, which need a dense decomposition
+ * because they are too ill-conditioned for the Levinson recursion. Assembling
+ * the matrix and factorizing it with a blocked LU are parallelized with
+ * OpenMP. Only available if the library is built with the CMake option
+ * FIR_OPENMP, the default is 1.
+ *
+ * The count is global to the process. Every design reads it once when it
+ * starts, so a change while other threads are designing only affects later
+ * designs. The workers of `firls_batch` ignore it and design single threaded,
+ * the batch already runs a design per thread. The count is also passed to
+ * Eigen (Eigen::setNbThreads), which does not synchronize it: do not call
+ * this function while a large design is factorizing on another thread.
+ *
+ * @param numThreads Number of threads, 0 for the number of processors
+ * @returns the number of threads that will be used, always 1 without
+ *      FIR_OPENMP
+ */
+extern "C" int firls_set_num_threads(int numThreads);
+
+/**
+ * Size of the workspace for `firls_ws`.
+ *
+ * @returns size in bytes, or 0 for invalid arguments
+ */
+extern "C" size_t firls_workspace_size(int numTaps, int numBands);
+
+/**
+ * Same as `firls`, but all arrays are allocated in the caller provided
+ * workspace, so repeated designs do no heap allocations. Only ill-conditioned
+ * designs, which fall back to a dense matrix decomposition, allocate that
+ * matrix on the heap.
+ *
+ * @param workspace Memory of at least `firls_workspace_size(numTaps, numBands)`
+ *      bytes, no alignment requirements.
+ * @param workspaceSize Size of workspace in bytes
+ * @returns 0 on success, error code on failure, FIR_EWORKSPACE if the
+ *      workspace is too small
+ */
+extern "C" int firls_ws(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+                        const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                        const FirFloat weight[], FirFloat fs, void *workspace,
+                        size_t workspaceSize);
+
+/**
+ * How `firls` solved the normal equations of a design.
+ */
+struct FirlsStats {
+    /* FIR_SOLVER_LEVINSON, FIR_SOLVER_LDLT, FIR_SOLVER_LU or FIR_SOLVER_COD */
+    int solver;
+    /* estimated condition number of the accepted (LEVINSON, LDLT, LU) or the
+     * rejected (COD) system, infinite if LDLT found it not positive definite */
+    FirFloat condition;
+};
+
+/**
+ * Same as `firls`, and report which solver was used. The Levinson recursion
+ * is tried first, then a LDLT decomposition of the folded matrix (LU for
+ * large designs with multiple threads, see `firls_set_num_threads`), and a
+ * complete orthogonal decomposition for (nearly) rank deficient designs,
+ * e.g. too many taps for the bands.
+ *
+ * @param stats Solver statistics, may be NULL
+ * @returns 0 on success, error code on failure
+ */
+extern "C" int firls_stats(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+                           const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                           const FirFloat weight[], FirFloat fs, FirlsStats *stats);
+
+/**
+ * Specification of one filter for `firls_batch`, see `firls` for the meaning
+ * of the fields.
+ */
+struct FirlsSpec {
+    int numBands;
+    const FirFloat *bands;
+    const FirFloat *desiredBegin;
+    const FirFloat *desiredEnd;
+    const FirFloat *weight;
+    FirFloat fs;
+};
+
+/**
+ * Design many filters with the same number of taps with `firls`, in parallel
+ * over multiple threads. Each thread reuses one workspace for all its designs.
+ *
+ * @param result Coefficients of the filters, must have room for
+ *      numFilters * numTaps values. Filter i starts at result[i * numTaps].
+ * @param numFilters Number of filters, number of elements in `specs`
+ * @param numTaps The number of taps in each FIR filter
+ * @param specs Specification of each filter
+ * @param status Per filter result of `firls`, may be NULL
+ * @param numThreads Maximum number of threads, 0 for the number of hardware
+ *      threads. With more than one thread, the designs ignore
+ *      `firls_set_num_threads` and run single threaded. If fewer threads can
+ *      be started, the started ones and the calling thread design all filters.
+ * @returns 0 if all designs succeeded, otherwise the error code of the first
+ *      failed filter
+ */
+extern "C" int firls_batch(FirFloat result[], int numFilters, int numTaps, const FirlsSpec specs[],
+                           int status[], int numThreads);
+
+/**
+ * Designer for repeated `firls` designs with the same number of taps. The
+ * matrix of the normal equations only depends on the bands, the weights and
+ * fs. The designer keeps its factorization for the specification of the last
+ * design: when only the desired gains change, e.g. while adjusting the gain of
+ * an equalizer band, a new design skips the matrix sums and reuses the
+ * reflection coefficients of the Levinson recursion. Ill-conditioned designs,
+ * which fall back to a dense factorization, take O(numTaps²) instead of
+ * O(numTaps³).
+ */
+struct FirlsDesigner;
+
+/**
+ * @param numTaps The number of taps of every design
+ * @returns designer, or NULL for invalid arguments. Free with `firls_designer_destroy`.
+ */
+extern "C" FirlsDesigner *firls_designer_create(int numTaps);
+
+/**
+ * Same as `firls` for the number of taps of the designer. Results equal
+ * those of `firls` within rounding.
+ *
+ * @returns 0 on success, error code on failure
+ */
+extern "C" int firls_designer_design(FirlsDesigner *designer, FirFloat result[], int numBands,
+                                     const FirFloat bands[], const FirFloat desiredBegin[],
+                                     const FirFloat desiredEnd[], const FirFloat weight[],
+                                     FirFloat fs);
+
+/**
+ * How the designer solves the normal equations of its cached specification,
+ * see `firls_stats`. The Levinson recursion is tried first, as in `firls`;
+ * only if it fails the designer factorizes the folded matrix with LDLT, or a
+ * complete orthogonal decomposition. With multiple threads, `firls` uses LU
+ * where the designer uses LDLT.
+ *
+ * @param stats Solver statistics
+ * @returns 0 on success, -1 if the designer has no cached specification yet
+ */
+extern "C" int firls_designer_stats(const FirlsDesigner *designer, FirlsStats *stats);
+
+extern "C" void firls_designer_destroy(FirlsDesigner *designer);
+
+/**
+ * Design a bank of numFilters filters that share the bands and the weights,
+ * but each have their own desired response. The normal equations are
+ * factorized once and solved for all desired responses together.
+ *
+ * @param result Coefficients of the filters, must have room for
+ *      numFilters * numTaps values. Filter k starts at result[k * numTaps].
+ * @param numFilters Number of filters
+ * @param desiredBegin Desired gain at the begin of each band, numBands
+ *      values per filter. Filter k starts at desiredBegin[k * numBands].
+ * @param desiredEnd Desired gain at the end of each band, same layout
+ * @returns 0 on success, error code on failure. See `firls` for the other
+ *      arguments.
+ */
+extern "C" int firls_multi(FirFloat result[], int numFilters, int numTaps, int numBands,
+                           const FirFloat bands[], const FirFloat desiredBegin[],
+                           const FirFloat desiredEnd[], const FirFloat weight[], FirFloat fs);
+
+/**
+ * Least squares design (see `firls`) with the minimum number of taps that
+ * meets a specification of the maximum deviation of the magnitude response
+ * from the desired response in every band.
+ *
+ * For a pass band ripple of R dB peak to peak, the deviation is
+ * (10^(R/20) - 1) / (10^(R/20) + 1); for a stop band attenuation of A dB it
+ * is 10^(-A/20).
+ *
+ * The search starts at Herrmann's estimate for the narrowest transition band,
+ * and brackets and bisects the number of taps, assuming that longer filters
+ * have smaller deviations. The q and b sums of the normal equations are
+ * shared by all tried lengths, and the frequency responses are checked with
+ * one freqz plan. Only odd numbers of taps are tried if the last band
+ * requires a nonzero gain at nyquist.
+ *
+ * @param result Coefficients of the filter, must have room for maxTaps values
+ * @param maxTaps Maximum number of taps
+ * @param weight Weight of each band, or NULL for 1 / maxDeviation
+ * @param maxDeviation Maximum absolute deviation of the magnitude from the
+ *      desired gain in each band. Length has to be `numBands`
+ * @param numTaps Number of taps of the result, may be NULL
+ * @param numSolves Number of designs that were tried, may be NULL
+ * @returns 0 on success, error code on failure. FIR_ESPEC if no design with
+ *      up to maxTaps taps meets the specification, or for a deviation that
+ *      is not positive. See `firls` for the other arguments.
+ */
+extern "C" int firls_minorder(FirFloat result[], int maxTaps, int numBands, const FirFloat bands[],
+                              const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                              const FirFloat weight[], FirFloat fs, const FirFloat maxDeviation[],
+                              int *numTaps, int *numSolves);
+
+/**
+ * FIR filter design using the Parks-McClellan (Remez exchange) algorithm.
+ *
+ *  Calculate the filter coefficients for the linear-phase (type I and II)
+ *  finite impulse response filter whose maximum weighted deviation from the
+ *  desired frequency response in the bands is minimal (equiripple). For the
+ *  same number of taps, the worst case ripple is lower than with `firls`,
+ *  at the expense of a larger error energy.
+ *
+ * The arguments are the same as for `firls`, except that all weights must be
+ * strictly positive. Transition bands between the bands are required for
+ * convergence.
+ *
+ * The iterations start from the extremal frequencies of the `firls` design.
+ *
+ * @returns 0 on success, error code on failure. FIR_ECONVERGENCE if the
+ *      algorithm did not converge, typically for a ripple below approx 1e-8
+ *      where rounding errors dominate: result then holds the `firls` design.
+ */
+extern "C" int firremez(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+                        const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                        const FirFloat weight[], FirFloat fs);
+
+/**
+ * FIR filter design with the window method (windowed sinc), as SciPy
+ * signal.firwin. Much faster than `firls` for long filters, but not optimal:
+ * e.g. for previews of a design.
+ *
+ * The ideal response has a constant gain in each band, and steps halfway the
+ * transition bands between the bands. The filter is scaled to the exact gain
+ * in the center of the first band with a nonzero gain (at 0 Hz or nyquist if
+ * the band includes them). Even numTaps give a type II filter, with a zero at
+ * nyquist.
+ *
+ * For the Kaiser window the stop band attenuation A in dB selects the window
+ * parameter beta. The transition band width (relative to fs) is then approx
+ * (A - 7.95) / (14.36 * (numTaps - 1)).
+ *
+ * @param bands See `firls`
+ * @param desired Gain of each band. Length has to be `numBands`
+ * @param window FIR_WINDOW_HANN, FIR_WINDOW_BLACKMAN or FIR_WINDOW_KAISER
+ * @param attenuation Stop band attenuation in dB for FIR_WINDOW_KAISER,
+ *      ignored for the other windows
+ * @returns 0 on success, error code on failure, FIR_EWINDOW for an unknown
+ *      window or a negative attenuation
+ */
+extern "C" int firwin(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+                      const FirFloat desired[], int window, FirFloat attenuation, FirFloat fs);
+
+/**
+ * Convert a filter, e.g. a linear phase design of `firls`, to the minimum
+ * phase filter with the same magnitude response, with the homomorphic
+ * (cepstral) method. A linear phase filter delays all frequencies by
+ * (numTaps - 1) / 2 samples, a minimum phase filter has the least delay
+ * possible for its magnitude response.
+ *
+ * The real cepstrum is calculated with FFTs of `oversampling * numTaps`
+ * points (rounded up to a power of 2). The cepstrum of zeros on the unit
+ * circle, e.g. in the stop band of a linear phase filter, decays slowly, and
+ * is aliased by a short FFT: more oversampling gives a more accurate
+ * magnitude response. The magnitude is limited to -240 dB relative to its
+ * maximum before taking the logarithm.
+ *
+ * @param result Minimum phase taps, must have room for numTaps values. May
+ *      not overlap `taps`.
+ * @param numTaps The number of taps in the filter
+ * @param taps  Array with taps
+ * @param oversampling FFT length per tap, 0 for the default (32)
+ * @returns 0 on success, error code on failure, FIR_EMEMORY if the FFTs could
+ *      not be allocated
+ */
+extern "C" int firminphase(FirFloat result[], int numTaps, const FirFloat taps[], int oversampling);
+
 /**
  * FIR frequency response (magnitude) calculation over full frequency range
  * using FFT. Most efficient for n-1 = power of 2, or n having many small
  * factors 2/3/5, e.g. for n = 2001 or 2049 points
  *
+ * Symmetric (linear phase) taps, as designed by `firls`, are detected
+ * automatically: for even n-1, their amplitude response is calculated with a
+ * real FFT of half the size.
+ *
  * @param frequencies Output frequencies, in range 0 .. fs/2
  * @param magnitudes Output magnitudes for the corresponding frequency
  * @param n     No of values in fresp / mag
  * @param fs    Sample frequency (Hz), used for scaling fresp
- * @param numTamps The number of taps in the filter
+ * @param numTaps The number of taps in the filter
  * @param taps  Array with taps
  * @returns 0 on success, -1 on failure
  */
 extern "C" int firfreqz(FirFloat frequencies[], FirFloat magnitudes[], int n, int numTaps,
                         const FirFloat taps[], FirFloat fs);
 
+/**
+ * Single precision version of `firfreqz`, with the FFT calculated in float:
+ * faster, for e.g. plotting. The relative error of the magnitudes is approx
+ * 1e-7 times the largest magnitude, so the stop band of filters with more than
+ * approx 120 dB attenuation is not resolved.
+ */
+extern "C" int firfreqz_f(float frequencies[], float magnitudes[], int n, int numTaps,
+                          const float taps[], float fs);
+
+/**
+ * FIR complex frequency response calculation over full frequency range using
+ * FFT, see `firfreqz`.
+ *
+ * @param real Output real part of the response
+ * @param imag Output imaginary part of the response
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfreqz_complex(FirFloat frequencies[], FirFloat real[], FirFloat imag[], int n,
+                                int numTaps, const FirFloat taps[], FirFloat fs);
+
+/**
+ * FIR frequency response (magnitude and phase) calculation over full
+ * frequency range using FFT, see `firfreqz`.
+ *
+ * @param magnitudes Output magnitudes, in dB if flags contains FIR_FREQZ_DB.
+ *      Values in dB are limited to -400 dB.
+ * @param phases Output unwrapped phase in radians
+ * @param flags 0 or FIR_FREQZ_DB
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfreqz_phase(FirFloat frequencies[], FirFloat magnitudes[], FirFloat phases[],
+                              int n, int numTaps, const FirFloat taps[], FirFloat fs, int flags);
+
+/**
+ * FIR group delay calculation over full frequency range using FFT, see
+ * `firfreqz`. The group delay is calculated from the FFT of the taps and the
+ * FFT of n * taps[n].
+ *
+ * @param delays Output group delay in samples. At zeros of the frequency
+ *      response, the group delay is undefined and set to 0.
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firgrpdelay(FirFloat frequencies[], FirFloat delays[], int n, int numTaps,
+                           const FirFloat taps[], FirFloat fs);
+
+/**
+ * FIR frequency response (magnitude) calculation at n equally spaced
+ * frequencies from fStart to fEnd (inclusive), e.g. to zoom in on the pass
+ * band ripple. Uses the chirp-z transform, so the cost is O(L log L) with
+ * L >= numTaps + n - 1, independent of the frequency range.
+ *
+ * @param frequencies Output frequencies, in range fStart .. fEnd
+ * @param magnitudes Output magnitudes for the corresponding frequency
+ * @param n     No of values in frequencies / magnitudes
+ * @param fStart First frequency, 0 <= fStart <= fEnd
+ * @param fEnd  Last frequency, fEnd <= fs/2
+ * @param numTaps The number of taps in the filter
+ * @param taps  Array with taps
+ * @param fs    Sample frequency (Hz)
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfreqz_zoom(FirFloat frequencies[], FirFloat magnitudes[], int n,
+                             FirFloat fStart, FirFloat fEnd, int numTaps, const FirFloat taps[],
+                             FirFloat fs);
+
+/**
+ * FIR frequency response (magnitude) calculation at an arbitrary list of
+ * frequencies, with the Goertzel algorithm. The cost is O(numTaps) per
+ * frequency, the most efficient method for a small number of frequencies.
+ *
+ * @param frequencies Input frequencies (Hz), any order
+ * @param magnitudes Output magnitudes for the corresponding frequency
+ * @param n     No of values in frequencies / magnitudes
+ * @param numTaps The number of taps in the filter
+ * @param taps  Array with taps
+ * @param fs    Sample frequency (Hz)
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfreqz_points(const FirFloat frequencies[], FirFloat magnitudes[], int n,
+                               int numTaps, const FirFloat taps[], FirFloat fs);
+
+/**
+ * Opaque plan for repeated frequency response calculations with the same
+ * number of output points.
+ */
+struct FirFreqzPlan;
+
+/**
+ * Create a plan for `firfreqz_plan_execute`. The FFT configuration, twiddles
+ * and buffers are calculated and allocated once, so executing the plan does no
+ * allocations.
+ *
+ * @param n     No of output values, must be at least 2
+ * @returns the plan, or NULL on failure. Release with `firfreqz_plan_destroy`.
+ */
+extern "C" FirFreqzPlan *firfreqz_plan_create(int n);
+
+/**
+ * Same as `firfreqz`, with the number of output values taken from the plan.
+ * A plan must not be executed concurrently from multiple threads.
+ *
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfreqz_plan_execute(FirFreqzPlan *plan, FirFloat frequencies[],
+                                     FirFloat magnitudes[], int numTaps, const FirFloat taps[],
+                                     FirFloat fs);
+
+/**
+ * Frequency response with a plan, combining all outputs of `firfreqz`,
+ * `firfreqz_complex`, `firfreqz_phase` and `firgrpdelay` with a single FFT of
+ * the taps (and one more for the group delay). Every output array may be NULL
+ * if it is not needed.
+ *
+ * @param flags 0 or FIR_FREQZ_DB
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfreqz_plan_response(FirFreqzPlan *plan, FirFloat frequencies[], FirFloat real[],
+                                      FirFloat imag[], FirFloat magnitudes[], FirFloat phases[],
+                                      FirFloat delays[], int numTaps, const FirFloat taps[],
+                                      FirFloat fs, int flags);
+
+/**
+ * Release a plan created with `firfreqz_plan_create`. NULL is allowed.
+ */
+extern "C" void firfreqz_plan_destroy(FirFreqzPlan *plan);
+
+/**
+ * Opaque streaming FIR filter, which keeps the input history between calls.
+ */
+struct FirFilter;
+
+/**
+ * Create a direct form FIR filter with the given taps, e.g. designed with
+ * `firls`. The taps are copied. Symmetric taps are detected and use half the
+ * number of multiplications.
+ *
+ * @param numTaps The number of taps in the filter
+ * @param taps  Array with taps
+ * @returns the filter, or NULL on failure. Release with `firfilter_destroy`.
+ */
+extern "C" FirFilter *firfilter_create(int numTaps, const FirFloat taps[]);
+
+/**
+ * Create a FIR filter with the given filtering method:
+ * - FIR_FILTER_DIRECT: direct form, as `firfilter_create`, no latency.
+ * - FIR_FILTER_FFT: overlap-save FFT convolution, in blocks of `blockSize`
+ *   samples. The output is delayed by `blockSize` samples. The cost per sample
+ *   is O(log(numTaps + blockSize)) for blockSize in the order of numTaps.
+ * - FIR_FILTER_PARTITIONED: uniformly partitioned overlap-save convolution:
+ *   the taps are split in partitions of `blockSize` taps, each convolved with
+ *   an FFT of 2 * blockSize points. The output is delayed by `blockSize`
+ *   samples. The cost per sample is O(log(blockSize) + numTaps / blockSize),
+ *   so long filters can run with a small latency.
+ * - FIR_FILTER_AUTO: the method with the lowest estimated cost for numTaps
+ *   and blockSize. A blockSize of 0 selects the direct form.
+ *
+ * @param blockSize Block size for FFT convolution, the maximum acceptable
+ *      latency in samples for FIR_FILTER_AUTO
+ * @returns the filter, or NULL on failure. Release with `firfilter_destroy`.
+ */
+extern "C" FirFilter *firfilter_create_method(int numTaps, const FirFloat taps[], int method,
+                                              int blockSize);
+
+/**
+ * Filter a block of samples. Consecutive calls continue where the previous
+ * call stopped, so a signal can be filtered in blocks of any size. A filter
+ * must not be used concurrently from multiple threads.
+ *
+ * @param input Input samples
+ * @param output Output samples, may be the same array as `input`. With
+ *      latency L, output[i] is the filtered input[i - L].
+ * @param n     No of samples in input / output
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfilter_process(FirFilter *filter, const FirFloat input[], FirFloat output[],
+                                 int n);
+
+/**
+ * @returns the method used by the filter (FIR_FILTER_DIRECT, FIR_FILTER_FFT or
+ *      FIR_FILTER_PARTITIONED), -1 for NULL
+ */
+extern "C" int firfilter_method(const FirFilter *filter);
+
+/**
+ * @returns the delay in samples of the filter output, in addition to the delay
+ *      of the taps, -1 for NULL
+ */
+extern "C" int firfilter_latency(const FirFilter *filter);
+
+/**
+ * Clear the input history of the filter, as if it was newly created.
+ */
+extern "C" void firfilter_reset(FirFilter *filter);
+
+/**
+ * Release a filter created with `firfilter_create` or
+ * `firfilter_create_method`. NULL is allowed.
+ */
+extern "C" void firfilter_destroy(FirFilter *filter);
+
+/**
+ * Opaque single precision streaming FIR filter.
+ */
+struct FirFilterF;
+
+/**
+ * Single precision versions of the `firfilter_*` functions, see
+ * `firfilter_create_method`. The taps, the samples, the direct form and the FFT
+ * are float, which has twice the number of SIMD lanes of double.
+ */
+extern "C" FirFilterF *firfilter_create_f(int numTaps, const float taps[]);
+extern "C" FirFilterF *firfilter_create_method_f(int numTaps, const float taps[], int method,
+                                                 int blockSize);
+extern "C" int firfilter_process_f(FirFilterF *filter, const float input[], float output[],
+                                   int n);
+extern "C" int firfilter_method_f(const FirFilterF *filter);
+extern "C" int firfilter_latency_f(const FirFilterF *filter);
+extern "C" void firfilter_reset_f(FirFilterF *filter);
+extern "C" void firfilter_destroy_f(FirFilterF *filter);
+
+/**
+ * Opaque streaming FIR filter for multiple channels with the same taps.
+ */
+struct FirFilterMulti;
+
+/**
+ * Create a direct form FIR filter for numChannels channels, which all use the
+ * same taps. This avoids the conversion to separate channels and the overhead
+ * of a `firfilter_create` filter per channel:
+ * - FIR_LAYOUT_INTERLEAVED: sample i of channel c is at [i * numChannels + c].
+ *   All channels are filtered in the same vector operations.
+ * - FIR_LAYOUT_PLANAR: sample i of channel c is at [c * n + i], for a call with
+ *   n samples per channel. The channels are filtered one after the other per
+ *   block of samples.
+ * Symmetric taps are detected as in `firfilter_create`.
+ *
+ * @param numChannels Number of channels, at least 1
+ * @param numTaps The number of taps in the filter
+ * @param taps  Array with taps
+ * @param layout FIR_LAYOUT_INTERLEAVED or FIR_LAYOUT_PLANAR
+ * @returns the filter, or NULL on failure. Release with
+ *      `firfilter_multi_destroy`.
+ */
+extern "C" FirFilterMulti *firfilter_multi_create(int numChannels, int numTaps,
+                                                  const FirFloat taps[], int layout);
+
+/**
+ * Filter a block of n samples per channel, see `firfilter_process`.
+ *
+ * @param input Input samples, n * numChannels values in the layout of the filter
+ * @param output Output samples in the same layout, may be the same array as
+ *      `input`
+ * @param n     No of samples per channel
+ * @returns 0 on success, -1 on failure
+ */
+extern "C" int firfilter_multi_process(FirFilterMulti *filter, const FirFloat input[],
+                                       FirFloat output[], int n);
+
+/**
+ * Clear the input history of all channels, as if the filter was newly created.
+ */
+extern "C" void firfilter_multi_reset(FirFilterMulti *filter);
+
+/**
+ * Release a filter created with `firfilter_multi_create`. NULL is allowed.
+ */
+extern "C" void firfilter_multi_destroy(FirFilterMulti *filter);
+
+/**
+ * Opaque polyphase resampler, which keeps the input history between calls.
+ */
+struct FirResampler;
+
+/**
+ * Create a polyphase resampler, which changes the sample rate by the rational
+ * factor interpolation / decimation. The input is upsampled by inserting
+ * interpolation - 1 zeros after every sample, filtered with the taps and
+ * downsampled by keeping every decimation-th sample, as SciPy upfirdn. Only
+ * the retained output samples are calculated, on the non-zero input samples.
+ *
+ * With interpolation 1, this is a decimator, with decimation 1 an
+ * interpolator. The taps are applied as given: for an interpolator with unity
+ * gain, design the filter with a pass band gain of `interpolation`.
+ *
+ * @param interpolation Upsampling factor L, at least 1
+ * @param decimation Downsampling factor M, at least 1
+ * @param numTaps The number of taps in the filter
+ * @param taps  Array with taps, e.g. designed with `firls` with a cutoff below
+ *      fs / (2 * max(L, M)) for sample rate fs = L times the input rate
+ * @returns the resampler, or NULL on failure. Release with
+ *      `firresampler_destroy`.
+ */
+extern "C" FirResampler *firresampler_create(int interpolation, int decimation, int numTaps,
+                                             const FirFloat taps[]);
+
+/**
+ * Resample a block of samples. Consecutive calls continue where the previous
+ * call stopped, so a signal can be resampled in blocks of any size. The first
+ * output sample corresponds to the first input sample.
+ *
+ * @param input Input samples
+ * @param n     No of samples in input
+ * @param output Output samples, must have room for ceil(n * L / M) values
+ * @returns the number of output samples, -1 on failure
+ */
+extern "C" int firresampler_process(FirResampler *resampler, const FirFloat input[], int n,
+                                    FirFloat output[]);
+
+/**
+ * Clear the input history of the resampler, as if it was newly created.
+ */
+extern "C" void firresampler_reset(FirResampler *resampler);
+
+/**
+ * Release a resampler created with `firresampler_create`. NULL is allowed.
+ */
+extern "C" void firresampler_destroy(FirResampler *resampler);
+
+/**
+ * Opaque single precision polyphase resampler.
+ */
+struct FirResamplerF;
+
+/**
+ * Single precision versions of the `firresampler_*` functions, with float taps
+ * and samples.
+ */
+extern "C" FirResamplerF *firresampler_create_f(int interpolation, int decimation, int numTaps,
+                                                const float taps[]);
+extern "C" int firresampler_process_f(FirResamplerF *resampler, const float input[], int n,
+                                      float output[]);
+extern "C" void firresampler_reset_f(FirResamplerF *resampler);
+extern "C" void firresampler_destroy_f(FirResamplerF *resampler);
+
 #endif
@@ -0,0 +1,51 @@
+#ifndef FIR_BANDS_HPP
+#define FIR_BANDS_HPP
+
+/*
+ * Check of the frequency bands and weights, shared by the band based designs
+ * (firls, firremez, firwin and the fixed size firls in fir_fixed.hpp).
+ */
+#include "fir.hpp"
+
+/*
+ * Scale the frequency bands relative to nyquist, and check the bands and the
+ * weights.
+ *
+ * @param weight NULL for designs without weights
+ * @returns 0 on success, error code on failure
+ */
+template <typename T, typename In>
+int firScaleBands(T bandsScaled[], int numBands, const In bands[], const In weight[], T nyq) {
+    // Check if frequencies are in range 0-1
+    for (int i = 0; i < 2 * numBands; i++) {
+        bandsScaled[i] = (T)bands[i] / nyq;
+        if (bandsScaled[i] < 0 || bandsScaled[i] > 1) {
+            return FIR_EBANDS;
+        }
+    }
+
+    // Check if frequency bands are non-zero width, monotonically increasing
+    for (int i = 0; i < numBands; i++) {
+        if (bandsScaled[2 * i + 1] <= bandsScaled[2 * i]) {
+            return FIR_EBANDS;
+        }
+        if (i > 0 && bandsScaled[2 * i] < bandsScaled[2 * i - 1]) {
+            return FIR_EBANDS;
+        }
+    }
+
+    // SciPy signal.firls rejects negative values of desired. The algorithm does
+    // seem to work correctly for negative values, so we don't check.
+
+    // Check if weight is positive
+    if (weight != NULL) {
+        for (int i = 0; i < numBands; i++) {
+            if (weight[i] < 0) {
+                return FIR_EWEIGHTS;
+            }
+        }
+    }
+    return 0;
+}
+
+#endif
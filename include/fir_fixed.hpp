@@ -0,0 +1,217 @@
+#ifndef FIR_FIXED_HPP
+#define FIR_FIXED_HPP
+
+/*
+ * Header-only firls and firfreqz for a number of taps and bands known at
+ * compile time. Intended for small filters (up to a few hundred taps) that
+ * are designed very often, e.g. in a parameter sweep: all arrays are fixed
+ * size arrays on the stack, there is no workspace, and the loops over taps and
+ * bands have constant trip counts. Only the fallback for ill-conditioned
+ * designs allocates: its fixed size Eigen matrices are too large for the stack.
+ *
+ * Results are the same as the runtime `firls` and `firfreqz` within rounding.
+ * Including this header requires Eigen3.
+ */
+#include "fir.hpp"
+#include "fir_bands.hpp"
+#include "fir_toeplitz.hpp"
+#include <Eigen/Core>
+#include <Eigen/QR>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+/* Upper limit for NumTaps, keeps the arrays on the stack below approx 20 KB */
+#define FIR_FIXED_MAX_TAPS 255
+
+/*
+ * Folded matrix of the fixed size firls and its decomposition, for the heap.
+ * Dynamic for size 1: the 1x1 fixed size decomposition trips gcc's
+ * -Warray-bounds in Eigen.
+ */
+template <int Size> struct FirFixedFolded {
+    static constexpr int Rows = (Size > 1) ? Size : Eigen::Dynamic;
+    typedef Eigen::Matrix<FirFloat, Rows, Rows> MatrixType;
+    typedef Eigen::Matrix<FirFloat, Rows, 1> VectorType;
+
+    MatrixType Q;
+    Eigen::CompleteOrthogonalDecomposition<MatrixType> od;
+
+    FirFixedFolded() : Q(Size, Size), od(Size, Size) {}
+
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+/**
+ * Same as the runtime `firls`, for NumTaps taps and NumBands bands.
+ *
+ * Same solvers as `firls`: the Levinson recursion, and a complete orthogonal
+ * decomposition for ill-conditioned designs. The LDLT tier of `firls` is
+ * skipped, for these sizes the decomposition hardly costs more. The fixed size saves the
+ * workspace and the loop overhead for small filters.
+ *
+ * @returns 0 on success, error code on failure
+ */
+template <int NumTaps, int NumBands>
+int firls(FirFloat (&result)[NumTaps], const FirFloat (&bands)[2 * NumBands],
+          const FirFloat (&desiredBegin)[NumBands], const FirFloat (&desiredEnd)[NumBands],
+          const FirFloat (&weight)[NumBands], FirFloat fs) {
+    static_assert(NumTaps >= 1 && NumTaps <= FIR_FIXED_MAX_TAPS, "NumTaps out of range");
+    static_assert(NumBands >= 1, "NumBands must be positive");
+    constexpr int M = (NumTaps - 1) / 2;
+    constexpr bool isType2 = (NumTaps % 2 == 0);
+    constexpr FirFloat halfExtra = isType2 ? 0.5 : 0.0;
+    const FirFloat pi = 3.14159265358979323846;
+
+    const FirFloat nyq = 0.5 * fs;
+    if (nyq <= 0.0) {
+        return FIR_EFREQUENCY;
+    }
+    FirFloat f[2 * NumBands];
+    const int error = firScaleBands(f, NumBands, bands, weight, nyq);
+    if (error != 0) {
+        return error;
+    }
+
+    // See firls.cpp for the derivation of q and b. Both are sums over the band
+    // edges of terms in sin(πif) and cos(πif), so per band edge and index one
+    // sin and cos is shared by q and b. For type II, b needs the angles
+    // π(i + 0.5)f, obtained by rotating over πf/2.
+    FirFloat q[NumTaps] = {};
+    FirFloat bSin[M + 1] = {};
+    FirFloat bCos[M + 1] = {};
+    for (int e = 0; e < 2 * NumBands; e++) {
+        const int j = e / 2;
+        const FirFloat sign = (e % 2 == 0) ? -weight[j] : weight[j];
+        const FirFloat slope = (desiredEnd[j] - desiredBegin[j]) / (f[2 * j + 1] - f[2 * j]);
+        const FirFloat offset = desiredBegin[j] - f[2 * j] * slope;
+        const FirFloat value = slope * f[e] + offset;
+        const FirFloat rotateSin = isType2 ? std::sin(0.5 * pi * f[e]) : 0.0;
+        const FirFloat rotateCos = isType2 ? std::cos(0.5 * pi * f[e]) : 1.0;
+
+        q[0] += sign * f[e];
+        if (isType2) {
+            // i = 0: the angle is πf/2
+            bSin[0] += sign * value * rotateSin;
+            bCos[0] += sign * slope * rotateCos;
+        } else {
+            // i = 0: integral of the linear desired response
+            bSin[0] += sign * f[e] * (0.5 * slope * f[e] + offset);
+        }
+        for (int i = 1; i <= M; i++) {
+            const FirFloat s = std::sin(pi * i * f[e]);
+            const FirFloat c = std::cos(pi * i * f[e]);
+            q[i] += sign * s;
+            bSin[i] += sign * value * (s * rotateCos + c * rotateSin);
+            bCos[i] += sign * slope * (c * rotateCos - s * rotateSin);
+        }
+        for (int i = M + 1; i < NumTaps; i++) {
+            q[i] += sign * std::sin(pi * i * f[e]);
+        }
+    }
+    for (int i = 1; i < NumTaps; i++) {
+        q[i] /= pi * i;
+    }
+
+    // Solve the equivalent Toeplitz system with Levinson, see firls.cpp
+    FirFloat d[NumTaps];
+    for (int i = 0; i < NumTaps; i++) {
+        const int bIndex = (i > M) ? (i - M - (isType2 ? 1 : 0)) : (M - i);
+        const FirFloat scale = (bIndex + halfExtra) * pi;
+        d[i] = (scale == 0.0) ? bSin[0] : bSin[bIndex] / scale + bCos[bIndex] / (scale * scale);
+    }
+    FirFloat x[NumTaps];
+    FirFloat scratch[5 * NumTaps];
+    if (firSolveToeplitz(x, NumTaps, q, d, scratch)) {
+        for (int i = 0; i < NumTaps; i++) {
+            result[i] = 0.5 * (x[i] + x[NumTaps - 1 - i]);
+        }
+        return 0;
+    }
+
+    // Ill-conditioned: complete orthogonal decomposition of the folded system
+    // Q a = b, with Q = toeplitz(q[:M+1]) + hankel(q[:M+1], q[M:]). Q and its
+    // decomposition are fixed size, but held on the heap: on the stack they
+    // would need several times (M+1)² values.
+    typedef FirFixedFolded<M + 1> Folded;
+    std::unique_ptr<Folded> folded(new Folded());
+    typename Folded::VectorType b(M + 1);
+    for (int i = 0; i <= M; i++) {
+        for (int j = 0; j <= M; j++) {
+            folded->Q(i, j) = q[(i >= j) ? (i - j) : (j - i)] + q[i + j + (isType2 ? 1 : 0)];
+        }
+        b(i) = d[M - i];
+    }
+    folded->od.compute(folded->Q);
+    const typename Folded::VectorType a = folded->od.solve(b);
+
+    if (!isType2) {
+        result[M] = 2 * a(0);
+        for (int i = 1; i <= M; i++) {
+            result[M + i] = result[M - i] = a(i);
+        }
+    } else {
+        for (int i = 0; i <= M; i++) {
+            result[M + 1 + i] = result[M - i] = a(i);
+        }
+    }
+    return 0;
+}
+
+/* cos and sin of the NumFreqs equidistant angles 0 .. π, calculated once per size */
+template <int NumFreqs> struct FirFixedFreqzAngles {
+    Eigen::Array<FirFloat, NumFreqs, 1> cos;
+    Eigen::Array<FirFloat, NumFreqs, 1> sin;
+
+    FirFixedFreqzAngles() {
+        const FirFloat pi = 3.14159265358979323846;
+        for (int k = 0; k < NumFreqs; k++) {
+            cos(k) = std::cos(pi * k / (NumFreqs - 1));
+            sin(k) = std::sin(pi * k / (NumFreqs - 1));
+        }
+    }
+};
+
+/**
+ * Same as the runtime `firfreqz`, for NumTaps taps and NumFreqs points.
+ *
+ * Every point is evaluated directly with the Clenshaw recurrence for the
+ * cosine and sine sums, vectorized over the points, in O(NumTaps * NumFreqs)
+ * operations. It needs no plan or allocation: much faster than `firfreqz`,
+ * which creates a plan per call, and for up to approx 10 taps also faster
+ * than `firfreqz_plan_execute`.
+ *
+ * @returns 0 on success, -1 on failure
+ */
+template <int NumTaps, int NumFreqs>
+int firfreqz(FirFloat (&frequencies)[NumFreqs], FirFloat (&magnitudes)[NumFreqs],
+             const FirFloat (&taps)[NumTaps], FirFloat fs) {
+    static_assert(NumTaps >= 1, "NumTaps must be positive");
+    static_assert(NumFreqs >= 2, "NumFreqs must be at least 2");
+    if (fs <= 0.0) {
+        return -1;
+    }
+    static const FirFixedFreqzAngles<NumFreqs> angles;
+
+    // Clenshaw b[n] = taps[n] + 2x b[n+1] - b[n+2], down to n = 1, for all
+    // frequencies at once: the recurrence is vectorized over the frequencies
+    Eigen::Array<FirFloat, NumFreqs, 1> bufferA = Eigen::Array<FirFloat, NumFreqs, 1>::Zero();
+    Eigen::Array<FirFloat, NumFreqs, 1> bufferB = Eigen::Array<FirFloat, NumFreqs, 1>::Zero();
+    Eigen::Array<FirFloat, NumFreqs, 1> *b1 = &bufferA;
+    Eigen::Array<FirFloat, NumFreqs, 1> *b2 = &bufferB;
+    const Eigen::Array<FirFloat, NumFreqs, 1> twoX = 2.0 * angles.cos;
+    for (int n = NumTaps - 1; n >= 1; n--) {
+        *b2 = taps[n] + twoX * *b1 - *b2;
+        std::swap(b1, b2);
+    }
+    const Eigen::Array<FirFloat, NumFreqs, 1> real = taps[0] + angles.cos * *b1 - *b2;
+    const Eigen::Array<FirFloat, NumFreqs, 1> imag = angles.sin * *b1;
+    Eigen::Map<Eigen::Array<FirFloat, NumFreqs, 1>> magnitudeMap(magnitudes);
+    magnitudeMap = (real.square() + imag.square()).sqrt();
+    for (int k = 0; k < NumFreqs; k++) {
+        frequencies[k] = 0.5 * fs * k / (NumFreqs - 1);
+    }
+    return 0;
+}
+
+#endif
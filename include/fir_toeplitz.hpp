@@ -0,0 +1,167 @@
+#ifndef FIR_TOEPLITZ_HPP
+#define FIR_TOEPLITZ_HPP
+
+/*
+ * Levinson solver for the symmetric Toeplitz normal equations of firls,
+ * shared by the runtime design in firls.cpp and the fixed size design in
+ * fir_fixed.hpp.
+ */
+#include <Eigen/Core>
+#include <cmath>
+#include <limits>
+
+/*
+ * Threshold on the estimated condition number of the normalized Toeplitz
+ * matrix, above which the Levinson solution is rejected. At this threshold the
+ * relative error of the taps is still below approx 1e-8 in double precision.
+ * Types with a smaller epsilon accept proportionally larger condition numbers.
+ */
+static constexpr double FIR_LEVINSON_MAX_CONDITION = 1e8;
+
+template <typename T> T firLevinsonMaxCondition() {
+    return (T)FIR_LEVINSON_MAX_CONDITION *
+           ((T)std::numeric_limits<double>::epsilon() / std::numeric_limits<T>::epsilon());
+}
+
+/*
+ * Solve the symmetric Toeplitz system T x = d, with T = toeplitz(t[:n]), using
+ * the Levinson recursion (Golub & Van Loan, Matrix Computations, algorithm
+ * 4.7.3) in O(n²) operations.
+ *
+ * The recursion is only stable for well conditioned positive definite T. To
+ * detect an ill-conditioned T, the same recursion simultaneously solves
+ * T z = u for a pseudo-random vector u of ±1. Since u has a component along
+ * every eigenvector, |z|/|u| is a good estimate of |inv(T)|.
+ *
+ * @param scratch Room for 5 * n values
+ * @param condition If not NULL and the recursion completes, the estimated
+ *      condition number |inv(T)| for T normalized to unit diagonal
+ * @param reflection If not NULL, room for n - 1 values: the reflection
+ *      coefficients of the recursion, for firSolveToeplitzReflection. They
+ *      only depend on T.
+ * @returns true on success, false if T is not (numerically) positive definite
+ *      or too ill-conditioned. x is undefined in the latter case.
+ */
+template <typename T>
+bool firSolveToeplitz(T x_[], int n, const T t[], const T d_[], T scratch[],
+                      T *condition = NULL, T reflection[] = NULL) {
+    if (t[0] <= 0.0) {
+        return false;
+    }
+    if (n == 1) {
+        x_[0] = d_[0] / t[0];
+        if (condition != NULL) {
+            *condition = 1.0;
+        }
+        return true;
+    }
+
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    Eigen::Map<Vector> x(x_, n);
+    Eigen::Map<const Vector> d(d_, n);
+    // normalize T to unit diagonal: r = t[1:] / t[0]
+    Eigen::Map<Vector> r(scratch, n - 1);
+    for (Eigen::Index i = 0; i < n - 1; i++) {
+        r(i) = t[i + 1] / t[0];
+    }
+    Eigen::Map<Vector> u(scratch + n, n);
+    unsigned int seed = 12345;
+    for (Eigen::Index i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        u(i) = (seed & 0x10000) ? 1.0 : -1.0;
+    }
+
+    // y: solution of the Yule-Walker equations, z: solution for u
+    Eigen::Map<Vector> y(scratch + 2 * n, n);
+    Eigen::Map<Vector> z(scratch + 3 * n, n);
+    Eigen::Map<Vector> y_reversed(scratch + 4 * n, n);
+    y(0) = -r(0);
+    x(0) = d(0) / t[0];
+    z(0) = u(0);
+    T beta = 1.0;
+    T alpha = -r(0);
+    if (reflection != NULL) {
+        reflection[0] = alpha;
+    }
+    for (Eigen::Index k = 1; k < n; k++) {
+        beta *= (1.0 - alpha * alpha);
+        if (beta <= 0.0) {
+            return false;
+        }
+        y_reversed.head(k) = y.head(k).reverse();
+        T mu = (d(k) / t[0] - r.head(k).dot(x.head(k).reverse())) / beta;
+        T nu = (u(k) - r.head(k).dot(z.head(k).reverse())) / beta;
+        x.head(k) += mu * y_reversed.head(k);
+        z.head(k) += nu * y_reversed.head(k);
+        x(k) = mu;
+        z(k) = nu;
+
+        if (k < n - 1) {
+            alpha = (-r(k) - r.head(k).dot(y_reversed.head(k))) / beta;
+            y.head(k) += alpha * y_reversed.head(k);
+            y(k) = alpha;
+            if (reflection != NULL) {
+                reflection[k] = alpha;
+            }
+        }
+    }
+
+    T estimate = z.norm() / u.norm();
+    if (condition != NULL) {
+        *condition = estimate;
+    }
+    return std::isfinite(estimate) && estimate < firLevinsonMaxCondition<T>();
+}
+
+/*
+ * Solve T x = d with the reflection coefficients of a successful
+ * firSolveToeplitz on the same T, in O(n²) operations. Skips the calculation
+ * of the reflection coefficients and the condition estimate: one dot product
+ * and two vector updates per step instead of three of each.
+ *
+ * @param scratch Room for 2 * n values
+ */
+template <typename T>
+void firSolveToeplitzReflection(T x_[], int n, const T t[], const T reflection[], const T d_[],
+                                T scratch[]) {
+    if (n == 1) {
+        x_[0] = d_[0] / t[0];
+        return;
+    }
+
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    Eigen::Map<Vector> x(x_, n);
+    Eigen::Map<const Vector> d(d_, n);
+    Eigen::Map<Vector> r(scratch, n - 1);
+    for (Eigen::Index i = 0; i < n - 1; i++) {
+        r(i) = t[i + 1] / t[0];
+    }
+    T *y = scratch + n;
+    Eigen::Map<Vector> yVector(y, n);
+    y[0] = reflection[0];
+    x(0) = d(0) / t[0];
+    T beta = 1.0;
+    for (Eigen::Index k = 1; k < n; k++) {
+        beta *= (1.0 - reflection[k - 1] * reflection[k - 1]);
+        T mu = (d(k) / t[0] - r.head(k).dot(x.head(k).reverse())) / beta;
+        x.head(k) += mu * yVector.head(k).reverse();
+        x(k) = mu;
+
+        if (k < n - 1) {
+            // y.head(k) += alpha * y.head(k).reverse(), in place
+            const T alpha = reflection[k];
+            for (Eigen::Index i = 0; i < k / 2; i++) {
+                const T front = y[i];
+                const T back = y[k - 1 - i];
+                y[i] = front + alpha * back;
+                y[k - 1 - i] = back + alpha * front;
+            }
+            if (k % 2 == 1) {
+                y[k / 2] += alpha * y[k / 2];
+            }
+            y[k] = alpha;
+        }
+    }
+}
+
+#endif
@@ -14,11 +14,10 @@ em++ -Wall -Wextra -fexceptions -O3 --closure 1 -flto \
   -Dkiss_fft_scalar=double -ffast-math -fomit-frame-pointer \
   $(pkg-config --cflags eigen3) -I../include -I../kissfft/include \
   -s EXPORT_ES6 -s MODULARIZE -s STRICT \
-  -s STACK_SIZE=200000 \
-  -s EXPORTED_FUNCTIONS=_firerror,_firls,_firfreqz,_malloc,_free,_leak_check,_stack_get_free \
+  -s EXPORTED_FUNCTIONS=_firerror,_firls,_firls_f,_firls_workspace_size,_firls_ws,_firls_stats,_firls_set_num_threads,_firls_batch,_firls_designer_create,_firls_designer_design,_firls_designer_stats,_firls_designer_destroy,_firls_multi,_firls_minorder,_firremez,_firls_antisymmetric,_firls_sampled,_firminphase,_firwin,_firfreqz,_firfreqz_f,_firfreqz_complex,_firfreqz_phase,_firgrpdelay,_firfreqz_zoom,_firfreqz_points,_firfreqz_plan_create,_firfreqz_plan_execute,_firfreqz_plan_response,_firfreqz_plan_destroy,_firfilter_create,_firfilter_create_method,_firfilter_process,_firfilter_method,_firfilter_latency,_firfilter_reset,_firfilter_destroy,_firfilter_create_f,_firfilter_create_method_f,_firfilter_process_f,_firfilter_method_f,_firfilter_latency_f,_firfilter_reset_f,_firfilter_destroy_f,_firfilter_multi_create,_firfilter_multi_process,_firfilter_multi_reset,_firfilter_multi_destroy,_firresampler_create,_firresampler_process,_firresampler_reset,_firresampler_destroy,_firresampler_create_f,_firresampler_process_f,_firresampler_reset_f,_firresampler_destroy_f,_malloc,_free,_leak_check,_stack_get_free \
   -s EXPORTED_RUNTIME_METHODS=cwrap \
   -o "${OUTPUT_FOLDER}/fir.mjs" \
-  ../source/firls.cpp ../source/firerror.cpp ../source/firfreqz.cpp \
+  ../source/firls.cpp ../source/firls_batch.cpp ../source/firremez.cpp ../source/firminphase.cpp ../source/firwin.cpp ../source/firerror.cpp ../source/firfreqz.cpp ../source/firfreqz_zoom.cpp ../source/firfilter.cpp ../source/firresample.cpp \
   ../kissfft/source/kiss_fft.cpp ../kissfft/source/kiss_fftr.cpp \
   ./sanitizer.cpp
 echo "Done"
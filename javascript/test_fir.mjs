@@ -92,10 +92,8 @@ factory().then(instance => {
   return instance;
 }).then(instance => {
   /*
-   * firfreqz needs 32 bytes/frequency on the stack + some margin, and the
-   * default stack is only 64 KB -> code only works if compiled with large
-   * stack, otherwise an out of bounds excpetion is thrown or address sanitizer
-   * crashes the application
+   * firfreqz needs 32 bytes/frequency for the FFT buffers. These are
+   * allocated on the heap, so this also works with the default 64 KB stack.
    */
   const NO_FREQS = 5001;
   console.log(`Testing firfreqz with ${NO_FREQS} frequencies`);
@@ -0,0 +1,91 @@
+#ifndef FIR_FFT_HPP
+#define FIR_FFT_HPP
+
+/*
+ * Real FFT of a fixed length, templated on the scalar type, for the filter
+ * and frequency response cores in the library. Not part of the public API.
+ *
+ * double uses kiss_fftr, which is built once with kiss_fft_scalar = double.
+ * float uses the FFT module of Eigen, whose default backend is a templated
+ * port of the same KISS FFT.
+ *
+ * init() also prepares the inverse transform, unless only forward transforms
+ * are needed. The spectrum has n / 2 + 1 bins. The inverse is not scaled: a
+ * forward and inverse transform multiply the signal with n.
+ */
+#include "kiss_fftr.h"
+#include <complex>
+#include <unsupported/Eigen/FFT>
+#include <vector>
+
+template <typename T> class FirRealFft;
+
+template <> class FirRealFft<double> {
+  public:
+    FirRealFft() = default;
+    FirRealFft(const FirRealFft &) = delete;
+    FirRealFft &operator=(const FirRealFft &) = delete;
+    ~FirRealFft() {
+        kiss_fftr_free(forwardCfg);
+        kiss_fftr_free(inverseCfg);
+    }
+
+    /* Allocate the configurations for length n, n must be even */
+    bool init(int n, bool inverse = true) {
+        forwardCfg = kiss_fftr_alloc(n, 0 /* is_inverse_fft */, NULL, NULL);
+        if (inverse) {
+            inverseCfg = kiss_fftr_alloc(n, 1 /* is_inverse_fft */, NULL, NULL);
+        }
+        return forwardCfg != NULL && (!inverse || inverseCfg != NULL);
+    }
+
+    /* kiss_fft_cpx has the layout of std::complex */
+    void forward(const double in[], std::complex<double> out[]) {
+        kiss_fftr(forwardCfg, in, reinterpret_cast<kiss_fft_cpx *>(out));
+    }
+
+    void inverse(const std::complex<double> in[], double out[]) {
+        kiss_fftri(inverseCfg, reinterpret_cast<const kiss_fft_cpx *>(in), out);
+    }
+
+    /* Smallest fast even length >= n */
+    static int fastLength(int n) { return kiss_fftr_next_fast_size_real(n); }
+
+  private:
+    kiss_fftr_cfg forwardCfg = NULL;
+    kiss_fftr_cfg inverseCfg = NULL;
+};
+
+template <> class FirRealFft<float> {
+  public:
+    /*
+     * Eigen allocates the twiddles and work buffers of a length on the first
+     * transform in each direction: transform zeros here, so forward and
+     * inverse don't allocate.
+     */
+    bool init(int n, bool inverse = true) {
+        length = n;
+        fft.SetFlag(Eigen::FFT<float>::HalfSpectrum);
+        fft.SetFlag(Eigen::FFT<float>::Unscaled);
+        std::vector<float> zeros((size_t)n, 0.0f);
+        std::vector<std::complex<float>> spectrum((size_t)(n / 2 + 1));
+        fft.fwd(spectrum.data(), zeros.data(), n);
+        if (inverse) {
+            fft.inv(zeros.data(), spectrum.data(), n);
+        }
+        return true;
+    }
+
+    void forward(const float in[], std::complex<float> out[]) { fft.fwd(out, in, length); }
+
+    void inverse(const std::complex<float> in[], float out[]) { fft.inv(out, in, length); }
+
+    /* Smallest fast length >= n, a multiple of 4 for the real FFT of Eigen */
+    static int fastLength(int n) { return 4 * kiss_fft_next_fast_size((n + 3) / 4); }
+
+  private:
+    Eigen::FFT<float> fft;
+    int length = 0;
+};
+
+#endif
@@ -7,6 +7,11 @@ static const char *fir_error_messages[] = {
     "Number of frequency bands must be positive!",
     "Frequency bands must be monotonic array with positive width!",
     "Weights must be positive!",
+    "Workspace too small!",
+    "Design did not converge!",
+    "Specification not met with the maximum number of taps!",
+    "Unknown window or invalid window parameter!",
+    "Memory allocation failed!",
     "Invalid error code!"};
 
 #define ARRAY_LENGTH(x) (sizeof(x) / sizeof(x[0]))
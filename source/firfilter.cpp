@@ -0,0 +1,515 @@
+/*
+ * Streaming FIR filter: direct form, or overlap-save FFT convolution for long
+ * filters, optionally with the taps split in partitions for low latency. And
+ * a direct form filter for many channels with the same taps.
+ *
+ * The single channel filter is templated on the sample type, for the double
+ * (FirFilter) and float (FirFilterF) entry points.
+ */
+#include "fir.hpp"
+#include "fir_fft.hpp"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <type_traits>
+#include <vector>
+
+/* Number of samples filtered per pass over the taps, the outputs stay in L1 cache */
+static constexpr int FILTER_BLOCK = 256;
+/* Same for the multichannel filter, in values (frames times channels) */
+static constexpr int MULTI_FILTER_BLOCK = 2048;
+
+template <typename T> using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+template <typename T> using ConstVectorMap = Eigen::Map<const Vector<T>>;
+template <typename T> using VectorMap = Eigen::Map<Vector<T>>;
+template <typename T> using ComplexArray = Eigen::Array<std::complex<T>, Eigen::Dynamic, 1>;
+template <typename T> using ConstComplexMap = Eigen::Map<const ComplexArray<T>>;
+template <typename T> using ComplexMap = Eigen::Map<ComplexArray<T>>;
+
+/*
+ * Relative cost of the methods, in units of one direct form multiply-add, as
+ * measured with speed_filter. A real FFT of length L costs approx
+ * FFT_COST * L * log2(L), multiplying the spectra approx SPECTRUM_COST * L.
+ * The folded symmetric direct form costs SYMMETRIC_COST per tap.
+ */
+static constexpr double FFT_COST = 1.5;
+static constexpr double SPECTRUM_COST = 4.0;
+static constexpr double SYMMETRIC_COST = 0.8;
+/* The float direct form has twice the SIMD lanes, the FFT (scalar butterflies) does not */
+static constexpr double FLOAT_DIRECT_COST = 0.6;
+
+/*
+ * Direct form: the history holds the last numTaps - 1 input samples, followed
+ * by room for a block of new samples, so every tap sees a contiguous input
+ * segment.
+ *
+ * Overlap-save: the frame holds the last fftLength input samples, of which the
+ * last blockSize samples are the block that is being collected. When the block
+ * is complete, the frame is convolved with the taps by FFT, and the last
+ * blockSize samples of the result are the output during the next block.
+ *
+ * Partitioned: overlap-save with fftLength = 2 * blockSize, on partitions of
+ * blockSize taps. The spectra of the last numPartitions frames are kept in a
+ * frequency domain delay line: partition k of the taps is applied to the frame
+ * of k blocks ago.
+ */
+template <typename T> struct FilterState {
+    int numTaps;
+    int method;
+    bool isSymmetric;
+    std::vector<T> taps;
+    std::vector<T> history;
+    std::vector<T> accumulator;
+
+    int blockSize = 0;
+    int fftLength = 0;
+    int position = 0; /* number of samples in the current block */
+    FirRealFft<T> fft;
+    std::vector<std::complex<T>> tapsSpectrum; /* scaled with 1 / fftLength */
+    std::vector<std::complex<T>> spectrum;
+    std::vector<T> frame;
+    std::vector<T> result;
+
+    int numPartitions = 0;
+    int delayLinePosition = 0; /* index of the newest spectrum in delayLine */
+    std::vector<std::complex<T>> delayLine;
+};
+
+struct FirFilter : FilterState<FirFloat> {};
+struct FirFilterF : FilterState<float> {};
+
+/* FFT length for overlap-save */
+template <typename T> static int overlapSaveLength(int numTaps, int blockSize) {
+    return FirRealFft<T>::fastLength(blockSize + numTaps - 1);
+}
+
+template <typename T> static double directCost(int numTaps, bool isSymmetric) {
+    const double precision = std::is_same<T, float>::value ? FLOAT_DIRECT_COST : 1.0;
+    return precision * numTaps * (isSymmetric ? SYMMETRIC_COST : 1.0);
+}
+
+/* cost per output sample */
+template <typename T> static double overlapSaveCost(int numTaps, int blockSize) {
+    const double L = overlapSaveLength<T>(numTaps, blockSize);
+    return (2.0 * FFT_COST * L * std::log2(L) + SPECTRUM_COST * L) / blockSize;
+}
+
+/* cost per output sample, each partition multiplies and adds blockSize + 1 bins */
+static double partitionedCost(int numTaps, int blockSize) {
+    const double L = 2.0 * blockSize;
+    const double numPartitions = (numTaps + blockSize - 1) / blockSize;
+    return (2.0 * FFT_COST * L * std::log2(L) + SPECTRUM_COST * (L + 2.0) * numPartitions) /
+           blockSize;
+}
+
+template <typename T> static int cheapestMethod(int numTaps, bool isSymmetric, int blockSize) {
+    if (blockSize < 1) {
+        return FIR_FILTER_DIRECT;
+    }
+    const double costDirect = directCost<T>(numTaps, isSymmetric);
+    const double costFft = overlapSaveCost<T>(numTaps, blockSize);
+    const double costPartitioned = partitionedCost(numTaps, blockSize);
+    if (costDirect <= costFft && costDirect <= costPartitioned) {
+        return FIR_FILTER_DIRECT;
+    }
+    return costFft <= costPartitioned ? FIR_FILTER_FFT : FIR_FILTER_PARTITIONED;
+}
+
+/*
+ * Direct form convolution of one block: y = Σ_k h[k] segment(N - 1 - k), with
+ * segment(offset) the block of inputs at the given delay in the history.
+ *
+ * The loop runs over the taps and updates all outputs of the block at once, so
+ * the inner operations are contiguous multiply-adds over the block, which Eigen
+ * vectorizes. For symmetric taps h[k] = h[N - 1 - k], both inputs of a pair are
+ * added before the multiplication, which halves the number of multiplications.
+ * The block and segments are vectors for one channel, and for multichannel
+ * filters all channels of the block at once.
+ */
+template <typename T, typename Accumulator, typename Segment>
+static void convolveBlock(Accumulator &y, const T h[], int numTaps, bool isSymmetric,
+                          Segment segment) {
+    y.setZero();
+    if (isSymmetric) {
+        const int half = numTaps / 2;
+        int k = 0;
+        for (; k + 1 < half; k += 2) {
+            y.noalias() += h[k] * (segment(numTaps - 1 - k) + segment(k)) +
+                           h[k + 1] * (segment(numTaps - 2 - k) + segment(k + 1));
+        }
+        for (; k < half; k++) {
+            y.noalias() += h[k] * (segment(numTaps - 1 - k) + segment(k));
+        }
+        if (numTaps % 2 == 1) {
+            y.noalias() += h[half] * segment(half);
+        }
+    } else {
+        int k = 0;
+        for (; k + 3 < numTaps; k += 4) {
+            y.noalias() += h[k] * segment(numTaps - 1 - k) + h[k + 1] * segment(numTaps - 2 - k) +
+                           h[k + 2] * segment(numTaps - 3 - k) +
+                           h[k + 3] * segment(numTaps - 4 - k);
+        }
+        for (; k < numTaps; k++) {
+            y.noalias() += h[k] * segment(numTaps - 1 - k);
+        }
+    }
+}
+
+template <typename T> static bool hasSymmetricTaps(int numTaps, const T taps[]) {
+    for (int i = 0; i < numTaps / 2; i++) {
+        if (taps[i] != taps[numTaps - 1 - i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Filter one block of n <= FILTER_BLOCK samples that are already appended to the
+ * history: y[i] = Σ_k h[k] x[i + N - 1 - k], with x the history.
+ */
+template <typename T> static void filterBlock(FilterState<T> *filter, T output[], int n) {
+    const T *x = filter->history.data();
+    VectorMap<T> y(filter->accumulator.data(), n);
+    auto segment = [x, n](int offset) { return ConstVectorMap<T>(x + offset, n); };
+    convolveBlock(y, filter->taps.data(), filter->numTaps, filter->isSymmetric, segment);
+    std::copy(y.data(), y.data() + n, output);
+}
+
+template <typename T>
+static void processDirect(FilterState<T> *filter, const T input[], T output[], int n) {
+    const int numTaps = filter->numTaps;
+    T *history = filter->history.data();
+    for (int start = 0; start < n; start += FILTER_BLOCK) {
+        const int blockSize = std::min(FILTER_BLOCK, n - start);
+        std::copy(input + start, input + start + blockSize, history + numTaps - 1);
+        filterBlock(filter, output + start, blockSize);
+        /* keep the last numTaps - 1 samples for the next block */
+        std::copy(history + blockSize, history + blockSize + numTaps - 1, history);
+    }
+}
+
+/*
+ * Circular convolution of the frame with the taps. The first numTaps - 1
+ * samples of the result are wrapped around, the last blockSize samples are the
+ * linear convolution.
+ */
+template <typename T> static void convolveFrame(FilterState<T> *filter) {
+    const int numBins = filter->fftLength / 2 + 1;
+    filter->fft.forward(filter->frame.data(), filter->spectrum.data());
+    ComplexMap<T> spectrum(filter->spectrum.data(), numBins);
+    spectrum *= ConstComplexMap<T>(filter->tapsSpectrum.data(), numBins);
+    filter->fft.inverse(filter->spectrum.data(), filter->result.data());
+}
+
+/*
+ * Store the spectrum of the frame in the delay line, and sum the products of
+ * all partitions of the taps with the spectra of the corresponding frames.
+ */
+template <typename T> static void convolvePartitioned(FilterState<T> *filter) {
+    const int fftLength = filter->fftLength;
+    const int numBins = fftLength / 2 + 1;
+    const int numPartitions = filter->numPartitions;
+    const int newest = filter->delayLinePosition;
+    const std::complex<T> *delayLine = filter->delayLine.data();
+    const std::complex<T> *tapsSpectrum = filter->tapsSpectrum.data();
+
+    filter->fft.forward(filter->frame.data(),
+                        filter->delayLine.data() + (size_t)newest * numBins);
+    ComplexMap<T> sum(filter->spectrum.data(), numBins);
+    sum.setZero();
+    for (int k = 0; k < numPartitions; k++) {
+        const int slot = (newest + k) % numPartitions;
+        sum += ConstComplexMap<T>(tapsSpectrum + (size_t)k * numBins, numBins) *
+               ConstComplexMap<T>(delayLine + (size_t)slot * numBins, numBins);
+    }
+    filter->fft.inverse(filter->spectrum.data(), filter->result.data());
+
+    /* the next spectrum replaces the oldest one */
+    filter->delayLinePosition = (newest + numPartitions - 1) % numPartitions;
+}
+
+template <typename T>
+static void processOverlapSave(FilterState<T> *filter, const T input[], T output[], int n) {
+    const int blockSize = filter->blockSize;
+    T *current = filter->frame.data() + filter->fftLength - blockSize;
+    const T *previous = filter->result.data() + filter->fftLength - blockSize;
+    for (int i = 0; i < n;) {
+        const int position = filter->position;
+        const int count = std::min(n - i, blockSize - position);
+        /* input before output: they may be the same array */
+        std::copy(input + i, input + i + count, current + position);
+        std::copy(previous + position, previous + position + count, output + i);
+        i += count;
+        filter->position += count;
+        if (filter->position == blockSize) {
+            if (filter->method == FIR_FILTER_PARTITIONED) {
+                convolvePartitioned(filter);
+            } else {
+                convolveFrame(filter);
+            }
+            /* drop the oldest block from the frame */
+            T *frame = filter->frame.data();
+            std::copy(frame + blockSize, frame + filter->fftLength, frame);
+            filter->position = 0;
+        }
+    }
+}
+
+/*
+ * Allocate the buffers for overlap-save and calculate the spectra of the
+ * partitions of the taps. Without partitions, all taps are one partition.
+ */
+template <typename T> static bool initBlockConvolution(FilterState<T> *filter, int blockSize) {
+    const int numTaps = filter->numTaps;
+    const bool isPartitioned = (filter->method == FIR_FILTER_PARTITIONED);
+    const int fftLength =
+        isPartitioned ? 2 * blockSize : overlapSaveLength<T>(numTaps, blockSize);
+    const int partitionSize = isPartitioned ? blockSize : numTaps;
+    const int numPartitions = (numTaps + partitionSize - 1) / partitionSize;
+    const size_t numBins = (size_t)(fftLength / 2 + 1);
+    filter->blockSize = blockSize;
+    filter->fftLength = fftLength;
+    if (!filter->fft.init(fftLength)) {
+        return false;
+    }
+    filter->frame.assign((size_t)fftLength, (T)0);
+    filter->result.assign((size_t)fftLength, (T)0);
+    filter->spectrum.resize(numBins);
+    filter->tapsSpectrum.resize(numBins * (size_t)numPartitions);
+    if (isPartitioned) {
+        filter->numPartitions = numPartitions;
+        filter->delayLinePosition = 0;
+        filter->delayLine.assign(numBins * (size_t)numPartitions, std::complex<T>());
+    }
+
+    /* the inverse FFT is not scaled: include 1 / fftLength in the taps */
+    std::vector<T> padded((size_t)fftLength);
+    for (int k = 0; k < numPartitions; k++) {
+        std::fill(padded.begin(), padded.end(), (T)0);
+        const int begin = k * partitionSize;
+        const int end = std::min(numTaps, begin + partitionSize);
+        for (int i = begin; i < end; i++) {
+            padded[(size_t)(i - begin)] = filter->taps[(size_t)i] / (T)fftLength;
+        }
+        filter->fft.forward(padded.data(), &filter->tapsSpectrum[numBins * (size_t)k]);
+    }
+    return true;
+}
+
+template <typename Filter, typename T>
+static Filter *createFilter(int numTaps, const T taps[], int method, int blockSize) {
+    if (numTaps < 1 || taps == NULL) {
+        return NULL;
+    }
+    const bool symmetric = hasSymmetricTaps(numTaps, taps);
+    if (method == FIR_FILTER_AUTO) {
+        method = cheapestMethod<T>(numTaps, symmetric, blockSize);
+    }
+    const bool isBlockMethod = (method == FIR_FILTER_FFT || method == FIR_FILTER_PARTITIONED);
+    if (method != FIR_FILTER_DIRECT && (!isBlockMethod || blockSize < 1)) {
+        return NULL;
+    }
+
+    Filter *filter = new Filter;
+    filter->numTaps = numTaps;
+    filter->method = method;
+    filter->isSymmetric = symmetric;
+    filter->taps.assign(taps, taps + numTaps);
+    if (isBlockMethod) {
+        if (!initBlockConvolution<T>(filter, blockSize)) {
+            delete filter;
+            return NULL;
+        }
+    } else {
+        filter->history.assign((size_t)(numTaps - 1 + FILTER_BLOCK), (T)0);
+        filter->accumulator.resize(FILTER_BLOCK);
+    }
+    return filter;
+}
+
+template <typename T>
+static int processFilter(FilterState<T> *filter, const T input[], T output[], int n) {
+    if (filter == NULL || n < 0) {
+        return -1;
+    }
+    if (filter->method != FIR_FILTER_DIRECT) {
+        processOverlapSave(filter, input, output, n);
+    } else {
+        processDirect(filter, input, output, n);
+    }
+    return 0;
+}
+
+template <typename T> static int filterMethod(const FilterState<T> *filter) {
+    return filter != NULL ? filter->method : -1;
+}
+
+template <typename T> static int filterLatency(const FilterState<T> *filter) {
+    if (filter == NULL) {
+        return -1;
+    }
+    return filter->method != FIR_FILTER_DIRECT ? filter->blockSize : 0;
+}
+
+template <typename T> static void resetFilter(FilterState<T> *filter) {
+    if (filter != NULL) {
+        std::fill(filter->history.begin(), filter->history.end(), (T)0);
+        std::fill(filter->frame.begin(), filter->frame.end(), (T)0);
+        std::fill(filter->result.begin(), filter->result.end(), (T)0);
+        std::fill(filter->delayLine.begin(), filter->delayLine.end(), std::complex<T>());
+        filter->delayLinePosition = 0;
+        filter->position = 0;
+    }
+}
+
+FirFilter *firfilter_create_method(int numTaps, const FirFloat taps[], int method,
+                                   int blockSize) {
+    return createFilter<FirFilter>(numTaps, taps, method, blockSize);
+}
+
+FirFilter *firfilter_create(int numTaps, const FirFloat taps[]) {
+    return firfilter_create_method(numTaps, taps, FIR_FILTER_DIRECT, 0);
+}
+
+int firfilter_process(FirFilter *filter, const FirFloat input[], FirFloat output[], int n) {
+    return processFilter<FirFloat>(filter, input, output, n);
+}
+
+int firfilter_method(const FirFilter *filter) { return filterMethod<FirFloat>(filter); }
+
+int firfilter_latency(const FirFilter *filter) { return filterLatency<FirFloat>(filter); }
+
+void firfilter_reset(FirFilter *filter) { resetFilter<FirFloat>(filter); }
+
+void firfilter_destroy(FirFilter *filter) { delete filter; }
+
+FirFilterF *firfilter_create_method_f(int numTaps, const float taps[], int method,
+                                      int blockSize) {
+    return createFilter<FirFilterF>(numTaps, taps, method, blockSize);
+}
+
+FirFilterF *firfilter_create_f(int numTaps, const float taps[]) {
+    return firfilter_create_method_f(numTaps, taps, FIR_FILTER_DIRECT, 0);
+}
+
+int firfilter_process_f(FirFilterF *filter, const float input[], float output[], int n) {
+    return processFilter<float>(filter, input, output, n);
+}
+
+int firfilter_method_f(const FirFilterF *filter) { return filterMethod<float>(filter); }
+
+int firfilter_latency_f(const FirFilterF *filter) { return filterLatency<float>(filter); }
+
+void firfilter_reset_f(FirFilterF *filter) { resetFilter<float>(filter); }
+
+void firfilter_destroy_f(FirFilterF *filter) { delete filter; }
+
+/*
+ * Direct form filter of numChannels channels with the same taps. The history
+ * holds the last numTaps - 1 frames, followed by room for a block of
+ * blockFrames frames, in the layout of the signal:
+ * - interleaved: frame i starts at history[i * numChannels]. The inputs of a
+ *   tap for all frames and channels of a block are one contiguous vector, so
+ *   the channels fill the SIMD lanes, also for a few channels.
+ * - planar: channel c starts at history[c * historyLength]. All channels of a
+ *   block are filtered in turn, while the taps and the block stay in L1 cache.
+ *   A tap-major loop over a blockFrames x numChannels matrix was slower: the
+ *   filter is bound by the loads of the inputs, not of the taps.
+ */
+struct FirFilterMulti {
+    int numChannels;
+    int numTaps;
+    int layout;
+    bool isSymmetric;
+    int blockFrames;
+    int historyLength; /* frames */
+    std::vector<FirFloat> taps;
+    std::vector<FirFloat> history;
+    std::vector<FirFloat> accumulator;
+};
+
+static void processInterleaved(FirFilterMulti *filter, const FirFloat input[], FirFloat output[],
+                               int n) {
+    const int numChannels = filter->numChannels;
+    const size_t keep = (size_t)(filter->numTaps - 1) * numChannels;
+    FirFloat *history = filter->history.data();
+    for (int start = 0; start < n; start += filter->blockFrames) {
+        const int values = std::min(filter->blockFrames, n - start) * numChannels;
+        const size_t offset = (size_t)start * numChannels;
+        std::copy(input + offset, input + offset + values, history + keep);
+        VectorMap<FirFloat> y(filter->accumulator.data(), values);
+        auto segment = [history, numChannels, values](int frame) {
+            return ConstVectorMap<FirFloat>(history + (size_t)frame * numChannels, values);
+        };
+        convolveBlock(y, filter->taps.data(), filter->numTaps, filter->isSymmetric, segment);
+        std::copy(y.data(), y.data() + values, output + offset);
+        /* keep the last numTaps - 1 frames for the next block */
+        std::copy(history + values, history + values + keep, history);
+    }
+}
+
+static void processPlanar(FirFilterMulti *filter, const FirFloat input[], FirFloat output[],
+                          int n) {
+    const int numChannels = filter->numChannels;
+    const int keep = filter->numTaps - 1;
+    const int historyLength = filter->historyLength;
+    FirFloat *history = filter->history.data();
+    for (int start = 0; start < n; start += filter->blockFrames) {
+        const int frames = std::min(filter->blockFrames, n - start);
+        for (int c = 0; c < numChannels; c++) {
+            const FirFloat *channel = input + (size_t)c * n + start;
+            FirFloat *channelHistory = history + (size_t)c * historyLength;
+            std::copy(channel, channel + frames, channelHistory + keep);
+            VectorMap<FirFloat> y(filter->accumulator.data(), frames);
+            auto segment = [channelHistory, frames](int frame) {
+                return ConstVectorMap<FirFloat>(channelHistory + frame, frames);
+            };
+            convolveBlock(y, filter->taps.data(), filter->numTaps, filter->isSymmetric, segment);
+            std::copy(y.data(), y.data() + frames, output + (size_t)c * n + start);
+            std::copy(channelHistory + frames, channelHistory + frames + keep, channelHistory);
+        }
+    }
+}
+
+FirFilterMulti *firfilter_multi_create(int numChannels, int numTaps, const FirFloat taps[],
+                                       int layout) {
+    if (numChannels < 1 || numTaps < 1 || taps == NULL ||
+        (layout != FIR_LAYOUT_INTERLEAVED && layout != FIR_LAYOUT_PLANAR)) {
+        return NULL;
+    }
+    FirFilterMulti *filter = new FirFilterMulti;
+    filter->numChannels = numChannels;
+    filter->numTaps = numTaps;
+    filter->layout = layout;
+    filter->isSymmetric = hasSymmetricTaps(numTaps, taps);
+    filter->blockFrames = std::max(1, MULTI_FILTER_BLOCK / numChannels);
+    filter->historyLength = numTaps - 1 + filter->blockFrames;
+    filter->taps.assign(taps, taps + numTaps);
+    filter->history.assign((size_t)filter->historyLength * numChannels, 0.0);
+    filter->accumulator.resize((size_t)filter->blockFrames * numChannels);
+    return filter;
+}
+
+int firfilter_multi_process(FirFilterMulti *filter, const FirFloat input[], FirFloat output[],
+                            int n) {
+    if (filter == NULL || n < 0) {
+        return -1;
+    }
+    if (filter->layout == FIR_LAYOUT_INTERLEAVED) {
+        processInterleaved(filter, input, output, n);
+    } else {
+        processPlanar(filter, input, output, n);
+    }
+    return 0;
+}
+
+void firfilter_multi_reset(FirFilterMulti *filter) {
+    if (filter != NULL) {
+        std::fill(filter->history.begin(), filter->history.end(), 0.0);
+    }
+}
+
+void firfilter_multi_destroy(FirFilterMulti *filter) { delete filter; }
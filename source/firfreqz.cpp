@@ -1,56 +1,358 @@
+/*
+ * Frequency response calculations with a real FFT. The plan and the
+ * calculations are templated on the scalar type, for the double (FirFreqzPlan,
+ * firfreqz, ...) and the float (firfreqz_f) entry points.
+ */
 #include "fir.hpp"
-#include "kiss_fftr.h"
+#include "fir_fft.hpp"
 #include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <vector>
 
-int firfreqz(FirFloat frequencies[], FirFloat magnitudes[], int n, int numTaps,
-             const FirFloat taps[], FirFloat fs) {
-    if (n < 1 || numTaps <= 0 || fs <= 0.0) {
-        return -1;
+static constexpr FirFloat PI = 3.141592653589793238462;
+
+/* Lower limit for magnitudes in dB, avoids -inf for zeros of the response */
+static constexpr FirFloat MIN_MAGNITUDE_DB = -400.0;
+
+/* magnitude in dB for flag FIR_FREQZ_DB */
+template <typename T> static T outputMagnitude(T magnitude, int flags) {
+    if (flags & FIR_FREQZ_DB) {
+        magnitude = (magnitude > 0) ? std::fmax((T)20 * std::log10(magnitude), (T)MIN_MAGNITUDE_DB)
+                                    : (T)MIN_MAGNITUDE_DB;
     }
+    return magnitude;
+}
+
+/*
+ * The FFTs and buffers of a plan are allocated when it is created. The second output buffer holds
+ * the FFT of n * h[n], for the group delay.
+ *
+ * When n - 1 is even, the plan also has a half size FFT and a cosine table for the linear phase
+ * fast path, see symmetricMagnitudes().
+ */
+template <typename T> struct FreqzPlan {
+    int n;
+    int fftInputLength;
+    bool hasFull;
+    bool hasHalf;
+    FirRealFft<T> fft;     /* real FFT on 2 (n - 1) points, if hasFull */
+    FirRealFft<T> halfFft; /* real FFT on n - 1 points, if hasHalf */
+    std::vector<T> in;
+    std::vector<std::complex<T>> out;
+    std::vector<std::complex<T>> outRamp;
+    std::vector<T> cosTable; /* cos(π k / (2 (n - 1))), k = 0 .. n - 1, if hasHalf */
+};
+
+struct FirFreqzPlan : FreqzPlan<FirFloat> {};
 
+/*
+ * @param symmetricOnly The plan is only used for the magnitudes of symmetric
+ *      taps: without the full size FFT if n - 1 is even
+ */
+template <typename Plan, typename T> static Plan *createPlan(int n, bool symmetricOnly = false) {
     /*
      * An FFT on 100 points gives 51 output points, including DC and Nyquist
      * frequency. Calculate fftInputLength to have correct output length.
      */
+    if (n < 2) {
+        return NULL;
+    }
     const int fftInputLength = 2 * (n - 1);
-    if (numTaps >= fftInputLength) {
-        return -1;
+    const int halfLength = n - 1;
+
+    Plan *plan = new Plan;
+    plan->n = n;
+    plan->fftInputLength = fftInputLength;
+    plan->hasHalf = (halfLength % 2 == 0);
+    plan->hasFull = !(symmetricOnly && plan->hasHalf);
+    plan->in.assign((size_t)fftInputLength, (T)0);
+    plan->out.resize((size_t)n);
+    plan->outRamp.resize((size_t)n);
+    if ((plan->hasFull && !plan->fft.init(fftInputLength, false /* inverse */)) ||
+        (plan->hasHalf && !plan->halfFft.init(halfLength, false /* inverse */))) {
+        delete plan;
+        return NULL;
+    }
+    if (plan->hasHalf) {
+        plan->cosTable.resize((size_t)n);
+        for (int k = 0; k < n; k++) {
+            plan->cosTable[(size_t)k] = (T)std::cos(PI * k / (2.0 * halfLength));
+        }
     }
+    return plan;
+}
+
+FirFreqzPlan *firfreqz_plan_create(int n) { return createPlan<FirFreqzPlan, FirFloat>(n); }
 
-    FirFloat frequencyDelta = (n > 1) ? fs / (2.0 * (n - 1)) : 0.0;
-    for (int i = 0; i < n; i++) {
-        frequencies[i] = i * frequencyDelta;
+template <typename T> static bool isSymmetric(int numTaps, const T taps[]) {
+    for (int i = 0; i < numTaps / 2; i++) {
+        if (taps[i] != taps[numTaps - 1 - i]) {
+            return false;
+        }
     }
+    return true;
+}
+
+/*
+ * Magnitude response of a linear phase (symmetric) filter, on a real FFT of half the size of the
+ * generic path.
+ *
+ * With N = n - 1 and center tap M, the response of a type I filter (odd number of taps) is
+ * e^(-jωM) A(ω), with the real amplitude A(ω) = h[M] + 2 Σ_{j=1..M} h[M+j] cos(jω). A type II
+ * filter (even number of taps) has A(ω) = 2 Σ_{j=0..M} h[M+1+j] cos((j+½)ω), which is rewritten
+ * as cos(ω/2) Σ_{j=0..M} d[j] cos(jω) with a backward recursion on the coefficients.
+ *
+ * The cosine series on ω = πk/N, k = 0..N, is a DCT-I. It is calculated on a real FFT of length N
+ * as in Numerical Recipes cosft1: the even outputs are the real parts of the FFT, the odd outputs
+ * follow from a running sum of the imaginary parts. With c[k] = cos(πk / 2N) from the plan, the
+ * folding needs sin(πj / N) = c[N - 2j] and cos(πj / N) = c[2j].
+ *
+ * Returns false if the plan has no half size FFT or the taps are not symmetric.
+ */
+template <typename T>
+static bool symmetricMagnitudes(FreqzPlan<T> *plan, T magnitudes[], int numTaps, const T taps[],
+                                int flags) {
+    if (!plan->hasHalf || !isSymmetric(numTaps, taps)) {
+        return false;
+    }
+
+    const int n = plan->n;
+    const int halfLength = n - 1;
+    T *f = plan->in.data();
+    const std::complex<T> *out = plan->out.data();
+    const T *cosTable = plan->cosTable.data();
+    const bool isType2 = (numTaps % 2 == 0);
+    const int M = (numTaps - 1) / 2;
 
     /*
-     * For each output value, we need 2 values in the input vector and 2 in the
-     * output vector, so 32 bytes/element. So for an output length of 5000, we
-     * need approx 150 kB. Default stack in Emscripten is 64 kb, so we must
-     * either extend the stack or allocate on the heap. For simplicity, we
-     * allocate on the stack.
+     * f[j] are the coefficients of the cosine series, with f[0] doubled: the DCT-I below
+     * weights f[0] with ½. f[N] is always 0, as M < N.
      */
-    kiss_fft_scalar in[fftInputLength];
-    kiss_fft_cpx out[fftInputLength / 2 + 1];
+    if (!isType2) {
+        f[0] = 2 * taps[M];
+        for (int j = 1; j <= M; j++) {
+            f[j] = 2 * taps[M + j];
+        }
+    } else {
+        /* with c[j] = 2 h[M+1+j]: d[M] = 2 c[M], d[j] = 2 c[j] - d[j+1], d[0] = c[0] - ½ d[1] */
+        f[M] = 4 * taps[2 * M + 1];
+        for (int j = M - 1; j >= 1; j--) {
+            f[j] = 4 * taps[M + 1 + j] - f[j + 1];
+        }
+        f[0] = (M >= 1) ? 2 * (2 * taps[M + 1] - (T)0.5 * f[1]) : 4 * taps[M + 1];
+    }
+    for (int j = M + 1; j <= halfLength; j++) {
+        f[j] = 0;
+    }
+
+    /* fold f into a sequence of length N, and calculate the first odd output directly */
+    T sumOdd = (T)0.5 * f[0];
+    f[0] = (T)0.5 * f[0];
+    for (int j = 1; j < halfLength / 2; j++) {
+        const T a = f[j];
+        const T b = f[halfLength - j];
+        const T mean = (T)0.5 * (a + b);
+        const T difference = cosTable[halfLength - 2 * j] * (a - b);
+        f[j] = mean - difference;
+        f[halfLength - j] = mean + difference;
+        sumOdd += cosTable[2 * j] * (a - b);
+    }
+    plan->halfFft.forward(f, plan->out.data());
+
+    /* the amplitudes overwrite the FFT input, which has room for n values */
+    T *amplitudes = f;
+    amplitudes[1] = sumOdd;
+    for (int k = 0; k <= halfLength / 2; k++) {
+        amplitudes[2 * k] = out[k].real();
+    }
+    for (int k = 1; k < halfLength / 2; k++) {
+        amplitudes[2 * k + 1] = amplitudes[2 * k - 1] - out[k].imag();
+    }
+
+    for (int k = 0; k < n; k++) {
+        const T amplitude = isType2 ? amplitudes[k] * cosTable[k] : amplitudes[k];
+        magnitudes[k] = outputMagnitude(std::fabs(amplitude), flags);
+    }
+    return true;
+}
+
+void firfreqz_plan_destroy(FirFreqzPlan *plan) { delete plan; }
+
+/*
+ * firfreqz_plan_response calculated in type T.
+ */
+template <typename T>
+static int planResponse(FreqzPlan<T> *plan, T frequencies[], T real[], T imag[], T magnitudes[],
+                        T phases[], T delays[], int numTaps, const T taps[], T fs, int flags) {
+    if (plan == NULL || numTaps <= 0 || fs <= 0) {
+        return -1;
+    }
+    const int n = plan->n;
+    const int fftInputLength = plan->fftInputLength;
+    if (numTaps >= fftInputLength) {
+        return -1;
+    }
+
+    if (frequencies != NULL) {
+        const T frequencyDelta = fs / (T)fftInputLength;
+        for (int i = 0; i < n; i++) {
+            frequencies[i] = (T)i * frequencyDelta;
+        }
+    }
 
-    /* Configuration: do a forward FFT, and allocate memory */
-    kiss_fftr_cfg cfg;
-    if ((cfg = kiss_fftr_alloc(fftInputLength, 0 /* is_inverse_fft */, NULL, NULL)) == NULL) {
+    /* only the magnitudes of a linear phase filter are requested: half size FFT is sufficient */
+    if (magnitudes != NULL && real == NULL && imag == NULL && phases == NULL && delays == NULL &&
+        symmetricMagnitudes(plan, magnitudes, numTaps, taps, flags)) {
+        return 0;
+    }
+    if (!plan->hasFull) {
         return -1;
     }
 
     /* input is impulse response (FIR taps) followed by zeroes */
+    T *in = plan->in.data();
+    const std::complex<T> *out = plan->out.data();
     for (int i = 0; i < numTaps; i++) {
         in[i] = taps[i];
     }
     for (int i = numTaps; i < fftInputLength; i++) {
-        in[i] = 0.0;
+        in[i] = 0;
+    }
+    plan->fft.forward(in, plan->out.data());
+
+    if (real != NULL && imag != NULL) {
+        for (int i = 0; i < n; i++) {
+            real[i] = out[i].real();
+            imag[i] = out[i].imag();
+        }
+    }
+
+    if (magnitudes != NULL) {
+        for (int i = 0; i < n; i++) {
+            magnitudes[i] = outputMagnitude(std::sqrt(std::norm(out[i])), flags);
+        }
     }
-    kiss_fftr(cfg, in, out);
-    free(cfg);
 
-    for (int i = 0; i < fftInputLength / 2 + 1; i++) {
-        magnitudes[i] = std::sqrt(out[i].r * out[i].r + out[i].i * out[i].i);
+    if (phases != NULL) {
+        /* unwrap: remove jumps larger than π by adding multiples of 2π */
+        const T pi = (T)PI;
+        T offset = 0;
+        T previous = 0;
+        for (int i = 0; i < n; i++) {
+            T phase = std::arg(out[i]);
+            if (i > 0) {
+                T jump = phase - previous;
+                offset -= 2 * pi * std::floor((jump + pi) / (2 * pi));
+            }
+            previous = phase;
+            phases[i] = phase + offset;
+        }
+    }
+
+    if (delays != NULL) {
+        /*
+         * Group delay in samples: τ(ω) = Re(G(ω) / H(ω)), with G the FFT of the ramp n * h[n].
+         * Where H is (numerically) zero, the group delay is undefined and set to 0, as SciPy does.
+         */
+        const std::complex<T> *outRamp = plan->outRamp.data();
+        T sumAbs = 0;
+        for (int i = 0; i < numTaps; i++) {
+            in[i] = (T)i * taps[i];
+            sumAbs += std::fabs(taps[i]);
+        }
+        plan->fft.forward(in, plan->outRamp.data());
+
+        const T singular = 10 * std::numeric_limits<T>::epsilon() * sumAbs;
+        for (int i = 0; i < n; i++) {
+            T power = std::norm(out[i]);
+            if (power <= singular * singular) {
+                delays[i] = 0;
+            } else {
+                delays[i] = (outRamp[i].real() * out[i].real() +
+                             outRamp[i].imag() * out[i].imag()) /
+                            power;
+            }
+        }
     }
 
     return 0;
 }
+
+int firfreqz_plan_response(FirFreqzPlan *plan, FirFloat frequencies[], FirFloat real[],
+                           FirFloat imag[], FirFloat magnitudes[], FirFloat phases[],
+                           FirFloat delays[], int numTaps, const FirFloat taps[], FirFloat fs,
+                           int flags) {
+    return planResponse<FirFloat>(plan, frequencies, real, imag, magnitudes, phases, delays,
+                                  numTaps, taps, fs, flags);
+}
+
+int firfreqz_plan_execute(FirFreqzPlan *plan, FirFloat frequencies[], FirFloat magnitudes[],
+                          int numTaps, const FirFloat taps[], FirFloat fs) {
+    return firfreqz_plan_response(plan, frequencies, NULL, NULL, magnitudes, NULL, NULL, numTaps,
+                                  taps, fs, 0);
+}
+
+/*
+ * Frequency response with a temporary plan of type Plan, for the functions
+ * without plan argument.
+ */
+template <typename Plan, typename T>
+static int responseWithoutPlan(T frequencies[], T real[], T imag[], T magnitudes[], T phases[],
+                               T delays[], int n, int numTaps, const T taps[], T fs, int flags) {
+    if (n < 1 || numTaps <= 0 || fs <= 0) {
+        return -1;
+    }
+
+    /* only the magnitudes of a linear phase filter: the full size FFT is not used */
+    const bool symmetricOnly = magnitudes != NULL && real == NULL && imag == NULL &&
+                               phases == NULL && delays == NULL && isSymmetric(numTaps, taps);
+
+    /*
+     * The FFT buffers need 32 bytes/output point. They are allocated on the
+     * heap by the plan: on the stack they would overflow the 64 kB default
+     * Emscripten stack from approx 2000 points.
+     */
+    Plan *plan = createPlan<Plan, T>(n, symmetricOnly);
+    if (plan == NULL) {
+        return -1;
+    }
+    int ret = planResponse<T>(plan, frequencies, real, imag, magnitudes, phases, delays, numTaps,
+                              taps, fs, flags);
+    delete plan;
+    return ret;
+}
+
+int firfreqz(FirFloat frequencies[], FirFloat magnitudes[], int n, int numTaps,
+             const FirFloat taps[], FirFloat fs) {
+    return responseWithoutPlan<FirFreqzPlan, FirFloat>(frequencies, NULL, NULL, magnitudes, NULL,
+                                                       NULL, n, numTaps, taps, fs, 0);
+}
+
+int firfreqz_complex(FirFloat frequencies[], FirFloat real[], FirFloat imag[], int n, int numTaps,
+                     const FirFloat taps[], FirFloat fs) {
+    if (real == NULL || imag == NULL) {
+        return -1;
+    }
+    return responseWithoutPlan<FirFreqzPlan, FirFloat>(frequencies, real, imag, NULL, NULL, NULL,
+                                                       n, numTaps, taps, fs, 0);
+}
+
+int firfreqz_phase(FirFloat frequencies[], FirFloat magnitudes[], FirFloat phases[], int n,
+                   int numTaps, const FirFloat taps[], FirFloat fs, int flags) {
+    return responseWithoutPlan<FirFreqzPlan, FirFloat>(frequencies, NULL, NULL, magnitudes, phases,
+                                                       NULL, n, numTaps, taps, fs, flags);
+}
+
+int firgrpdelay(FirFloat frequencies[], FirFloat delays[], int n, int numTaps,
+                const FirFloat taps[], FirFloat fs) {
+    return responseWithoutPlan<FirFreqzPlan, FirFloat>(frequencies, NULL, NULL, NULL, NULL, delays,
+                                                       n, numTaps, taps, fs, 0);
+}
+
+int firfreqz_f(float frequencies[], float magnitudes[], int n, int numTaps, const float taps[],
+               float fs) {
+    return responseWithoutPlan<FreqzPlan<float>, float>(frequencies, NULL, NULL, magnitudes, NULL,
+                                                         NULL, n, numTaps, taps, fs, 0);
+}
@@ -0,0 +1,151 @@
+/*
+ * FIR frequency response (magnitude) on other frequency grids than the
+ * equally spaced 0 .. fs/2 grid of firfreqz.
+ */
+#include "fir.hpp"
+#include "kiss_fft.h"
+#include <cmath>
+#include <vector>
+
+static constexpr FirFloat PI = 3.141592653589793238462;
+
+/* exp(-jπ ratio k²), with the phase reduced modulo 2 before multiplying with π */
+static kiss_fft_cpx chirp(FirFloat ratio, int k) {
+    FirFloat kk = (FirFloat)k * (FirFloat)k;
+    FirFloat phase = -PI * std::fmod(ratio * kk, 2.0);
+    kiss_fft_cpx result;
+    result.r = std::cos(phase);
+    result.i = std::sin(phase);
+    return result;
+}
+
+static kiss_fft_cpx multiply(kiss_fft_cpx a, kiss_fft_cpx b) {
+    kiss_fft_cpx result;
+    result.r = a.r * b.r - a.i * b.i;
+    result.i = a.r * b.i + a.i * b.r;
+    return result;
+}
+
+static kiss_fft_cpx conjugate(kiss_fft_cpx a) {
+    a.i = -a.i;
+    return a;
+}
+
+int firfreqz_zoom(FirFloat frequencies[], FirFloat magnitudes[], int n, FirFloat fStart,
+                  FirFloat fEnd, int numTaps, const FirFloat taps[], FirFloat fs) {
+    if (n < 1 || numTaps <= 0 || fs <= 0.0) {
+        return -1;
+    }
+    if (fStart < 0.0 || fEnd < fStart || fEnd > 0.5 * fs) {
+        return -1;
+    }
+
+    /*
+     * Chirp-z transform with Bluestein's algorithm: with W = exp(-j2πΔf/fs)
+     * and nk = (n² + k² - (k-n)²) / 2, the response at fStart + kΔf is
+     *     H(k) = W^(k²/2) Σ [h(n) exp(-j2πn fStart/fs) W^(n²/2)] W^(-(k-n)²/2)
+     * The sum is a convolution, calculated with FFTs of a length L >= numTaps
+     * + n - 1, so the cost is O(L log L) for any frequency range.
+     */
+    const FirFloat frequencyDelta = (n > 1) ? (fEnd - fStart) / (n - 1) : 0.0;
+    const FirFloat deltaRatio = frequencyDelta / fs; // W = exp(-j2π deltaRatio)
+    const FirFloat startRatio = fStart / fs;
+    const int L = kiss_fft_next_fast_size(numTaps + n - 1);
+
+    kiss_fft_cfg forward = kiss_fft_alloc(L, 0, NULL, NULL);
+    kiss_fft_cfg inverse = kiss_fft_alloc(L, 1, NULL, NULL);
+    if (forward == NULL || inverse == NULL) {
+        kiss_fft_free(forward);
+        kiss_fft_free(inverse);
+        return -1;
+    }
+
+    std::vector<kiss_fft_cpx> y((size_t)L);
+    std::vector<kiss_fft_cpx> v((size_t)L);
+    std::vector<kiss_fft_cpx> Y((size_t)L);
+    std::vector<kiss_fft_cpx> V((size_t)L);
+
+    // y(m) = h(m) exp(-j2πm fStart/fs) W^(m²/2), zero padded
+    for (int m = 0; m < L; m++) {
+        if (m < numTaps) {
+            FirFloat phase = -2.0 * PI * std::fmod(startRatio * m, 1.0);
+            kiss_fft_cpx shift;
+            shift.r = taps[m] * std::cos(phase);
+            shift.i = taps[m] * std::sin(phase);
+            y[(size_t)m] = multiply(shift, chirp(deltaRatio, m));
+        } else {
+            y[(size_t)m].r = y[(size_t)m].i = 0.0;
+        }
+        v[(size_t)m].r = v[(size_t)m].i = 0.0;
+    }
+    // v(j) = W^(-j²/2) for j = -(numTaps-1) .. n-1, negative indexes wrapped around
+    for (int j = 0; j < n; j++) {
+        v[(size_t)j] = conjugate(chirp(deltaRatio, j));
+    }
+    for (int j = 1; j < numTaps; j++) {
+        v[(size_t)(L - j)] = conjugate(chirp(deltaRatio, j));
+    }
+
+    kiss_fft(forward, y.data(), Y.data());
+    kiss_fft(forward, v.data(), V.data());
+    for (int i = 0; i < L; i++) {
+        Y[(size_t)i] = multiply(Y[(size_t)i], V[(size_t)i]);
+    }
+    kiss_fft(inverse, Y.data(), y.data());
+    kiss_fft_free(forward);
+    kiss_fft_free(inverse);
+
+    // the chirp W^(k²/2) has modulus 1 and does not change the magnitude
+    for (int k = 0; k < n; k++) {
+        frequencies[k] = fStart + k * frequencyDelta;
+        const kiss_fft_cpx &g = y[(size_t)k];
+        magnitudes[k] = std::sqrt(g.r * g.r + g.i * g.i) / L;
+    }
+    return 0;
+}
+
+int firfreqz_points(const FirFloat frequencies[], FirFloat magnitudes[], int n, int numTaps,
+                    const FirFloat taps[], FirFloat fs) {
+    if (n < 0 || numTaps <= 0 || fs <= 0.0) {
+        return -1;
+    }
+
+    /*
+     * Goertzel algorithm, s(k) = h(k) + 2cos(ω)s(k-1) - s(k-2), in the
+     * modification of Reinsch: near ω = 0 and ω = π the plain recurrence loses
+     * accuracy as 2cos(ω) approaches ±2. Instead, the recurrence runs on the
+     * difference (cos(ω) >= 0) or sum (cos(ω) < 0) of successive values, with
+     * the small factors -4sin²(ω/2) and 4cos²(ω/2) calculated accurately.
+     */
+    for (int i = 0; i < n; i++) {
+        FirFloat omega = 2.0 * PI * frequencies[i] / fs;
+        FirFloat s = 0.0; // s(k-1)
+        FirFloat power;
+        if (std::cos(omega) >= 0.0) {
+            FirFloat sine = std::sin(0.5 * omega);
+            FirFloat lambda = -4.0 * sine * sine;
+            FirFloat d = 0.0; // s(k-1) - s(k-2)
+            FirFloat s_previous = 0.0;
+            for (int k = 0; k < numTaps; k++) {
+                d = taps[k] + lambda * s + d;
+                s_previous = s;
+                s += d;
+            }
+            // |H|² = s(N-1)² + s(N-2)² - 2cos(ω)s(N-1)s(N-2)
+            power = d * d - lambda * s * s_previous;
+        } else {
+            FirFloat cosine = std::cos(0.5 * omega);
+            FirFloat mu = 4.0 * cosine * cosine;
+            FirFloat e = 0.0; // s(k-1) + s(k-2)
+            FirFloat s_previous = 0.0;
+            for (int k = 0; k < numTaps; k++) {
+                e = taps[k] + mu * s - e;
+                s_previous = s;
+                s = e - s;
+            }
+            power = e * e - mu * s * s_previous;
+        }
+        magnitudes[i] = std::sqrt(std::fmax(power, 0.0));
+    }
+    return 0;
+}
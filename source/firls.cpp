@@ -3,60 +3,453 @@
  * This is a translation of SciPy signal.firls (only type I filters) to C++, later extended for type II filters.
  */
 #include "fir.hpp"
+#include "fir_bands.hpp"
+#include "fir_toeplitz.hpp"
+#include "firls_threads.hpp"
+#include "kiss_fft.h"
+#include "kiss_fftr.h"
+#include <Eigen/Cholesky>
 #include <Eigen/Core>
+#include <Eigen/LU>
 #include <Eigen/QR>
 #include <cmath>
 
-using Matrix = Eigen::MatrixXd;
-using Vector = Eigen::VectorXd;
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
 
-static constexpr FirFloat PI = 3.141592653589793238462;
-static FirFloat sinc(FirFloat x) noexcept { return (x == 0) ? 1.0 : sin(x * PI) / (x * PI); }
+#ifdef FIR_OPENMP
+#include <omp.h>
+#endif
 
-int firls(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
-          const FirFloat desiredBegin[], const FirFloat desiredEnd[], const FirFloat weight[],
-          FirFloat fs) {
-    if (numTaps < 1) {
-        return FIR_ENUMTAPS;
+/*
+ * The design is templated on the scalar type T of the calculations, and the
+ * scalar type In of the arguments and the result. Single precision designs
+ * are calculated in double precision: the normal equations square the
+ * condition number, so a float solution would be too inaccurate.
+ */
+template <typename T> using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+template <typename T> using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+template <typename T> using VectorMap = Eigen::Map<Vector<T>>;
+template <typename T> using ArrayMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+template <typename T> static constexpr T pi() { return (T)3.14159265358979323846264338327950288L; }
+
+/*
+ * Bump allocator for arrays on a caller provided workspace. Every array is
+ * aligned for SIMD loads. With workspace NULL, it only counts the number of
+ * bytes needed.
+ */
+class Workspace {
+  public:
+    static constexpr uintptr_t ALIGNMENT = 64;
+
+    // When counting, assume the worst case misaligned workspace address
+    Workspace(void *workspace, size_t size)
+        : _address(workspace != NULL ? (uintptr_t)workspace : 1), _size(size), _used(0),
+          _counting(workspace == NULL) {}
+
+    /* @returns array of n values, or NULL if the workspace is too small (or counting only) */
+    template <typename T> T *allocate(int n) {
+        uintptr_t start = (_address + _used + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        _used = (size_t)(start - _address) + sizeof(T) * (size_t)n;
+        if (_counting || _used > _size) {
+            return NULL;
+        }
+        return (T *)start;
+    }
+
+    size_t used() const { return _used; }
+
+  private:
+    uintptr_t _address;
+    size_t _size;
+    size_t _used;
+    bool _counting;
+};
+
+/*
+ * Number of angle addition steps between exact evaluations of sin and cos in
+ * EdgeAngles. Every step adds a rounding error of a few ulp, so the absolute
+ * error of the sin and cos values stays below approx 2 * TRIG_RESYNC * epsilon
+ * (1.5e-14 in double precision), independent of the number of taps.
+ */
+static constexpr int TRIG_RESYNC = 32;
+
+/*
+ * Threads for the dense fallback of large designs, see firls_set_num_threads.
+ * Every design reads the count once, so a change while designs are running
+ * only affects later designs. Below PARALLEL_MIN_SIZE columns of Q the
+ * threading overhead dominates.
+ */
+static std::atomic<int> numThreads(1);
+static constexpr int PARALLEL_MIN_SIZE = 256;
+
+/* set by FirlsSingleThreaded for the designs on this thread */
+static thread_local bool singleThreaded = false;
+
+FirlsSingleThreaded::FirlsSingleThreaded(bool enabled) : _previous(singleThreaded) {
+    singleThreaded = _previous || enabled;
+}
+
+FirlsSingleThreaded::~FirlsSingleThreaded() { singleThreaded = _previous; }
+
+/* Number of threads for a design with numTaps taps */
+static int designThreads(int numTaps) {
+    if (singleThreaded || (numTaps - 1) / 2 + 1 < PARALLEL_MIN_SIZE) {
+        return 1;
+    }
+    return numThreads.load();
+}
+
+/*
+ * sin(π(i + offset)f) and cos(π(i + offset)f) for all band edges f at once,
+ * for i = 0, 1, 2, ... Every step rotates the angles of all edges over πf
+ * with the angle addition formulas, vectorized over the edges. Only every
+ * TRIG_RESYNC steps, sin and cos are evaluated exactly, to limit the
+ * accumulated rounding errors.
+ */
+template <typename T> class EdgeAngles {
+  public:
+    static constexpr int BUFFER_SIZE = 5; // buffer values per edge
+
+    /* @param buffer Room for BUFFER_SIZE * numEdges values */
+    EdgeAngles(T buffer[], const T edges[], int numEdges, T offset)
+        : sin(buffer, numEdges), cos(buffer + numEdges, numEdges),
+          _stepSin(buffer + 2 * numEdges, numEdges), _stepCos(buffer + 3 * numEdges, numEdges),
+          _next(buffer + 4 * numEdges, numEdges), _edges(edges, numEdges), _offset(offset),
+          _i(0) {
+        _stepSin = (pi<T>() * _edges).sin();
+        _stepCos = (pi<T>() * _edges).cos();
+        synchronize();
+    }
+
+    /* advance to the next i */
+    void next() {
+        _i++;
+        if (_i % TRIG_RESYNC == 0) {
+            synchronize();
+            return;
+        }
+        _next = sin * _stepCos + cos * _stepSin;
+        cos = cos * _stepCos - sin * _stepSin;
+        sin = _next;
+    }
+
+    ArrayMap<T> sin;
+    ArrayMap<T> cos;
+
+  private:
+    void synchronize() {
+        sin = ((_i + _offset) * pi<T>() * _edges).sin();
+        cos = ((_i + _offset) * pi<T>() * _edges).cos();
+    }
+
+    ArrayMap<T> _stepSin;
+    ArrayMap<T> _stepCos;
+    ArrayMap<T> _next;
+    Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> _edges;
+    T _offset;
+    int _i;
+};
+
+/*
+ * All arrays used by firls. Solving the (rarely needed) fallback with a
+ * dense decomposition allocates its matrix on the heap.
+ */
+template <typename T> struct FirlsBuffers {
+    T *bandsScaled; // 2 * numBands
+    T *qWeight;     // 2 * numBands
+    T *bSinWeight;  // 2 * numBands
+    T *bCosWeight;  // 2 * numBands
+    T *angles;      // EdgeAngles<T>::BUFFER_SIZE * 2 * numBands
+    T *q;           // numTaps
+    T *b;           // M + 1
+    T *d;           // numTaps
+    T *x;           // numTaps
+    T *scratch;     // 5 * numTaps, for firSolveToeplitz
+
+    /* @returns true if all buffers fit in the workspace */
+    bool allocate(Workspace &ws, int numTaps, int numBands) {
+        int M = (numTaps - 1) / 2;
+        bandsScaled = ws.allocate<T>(2 * numBands);
+        qWeight = ws.allocate<T>(2 * numBands);
+        bSinWeight = ws.allocate<T>(2 * numBands);
+        bCosWeight = ws.allocate<T>(2 * numBands);
+        angles = ws.allocate<T>(EdgeAngles<T>::BUFFER_SIZE * 2 * numBands);
+        q = ws.allocate<T>(numTaps);
+        b = ws.allocate<T>(M + 1);
+        d = ws.allocate<T>(numTaps);
+        x = ws.allocate<T>(numTaps);
+        scratch = ws.allocate<T>(5 * numTaps);
+        return scratch != NULL && x != NULL && d != NULL && b != NULL && q != NULL &&
+               angles != NULL && bCosWeight != NULL && bSinWeight != NULL && qWeight != NULL &&
+               bandsScaled != NULL;
+    }
+};
+
+template <typename T> static size_t workspaceSize(int numTaps, int numBands) {
+    if (numTaps < 1 || numBands <= 0) {
+        return 0;
+    }
+    Workspace ws(NULL, 0);
+    FirlsBuffers<T> buffers;
+    buffers.allocate(ws, numTaps, numBands);
+    return ws.used();
+}
+
+/*
+ * Per band edge weights of the sums for q and b, see design(): -W at the
+ * start and W at the end of a band for q, times (mf+c) and m for b.
+ */
+template <typename T, typename In>
+static void edgeWeights(ArrayMap<T> &qWeight, ArrayMap<T> &bSinWeight, ArrayMap<T> &bCosWeight,
+                        int numBands, const T bandsScaled[], const In desiredBegin[],
+                        const In desiredEnd[], const In weight[]) {
+    for (int j = 0; j < numBands; j++) {
+        // Choose m and c such that we are at the start and end weights
+        T m = ((T)desiredEnd[j] - (T)desiredBegin[j]) /
+              (bandsScaled[2 * j + 1] - bandsScaled[2 * j]);
+        T c = (T)desiredBegin[j] - bandsScaled[2 * j] * m;
+        for (int e = 2 * j; e < 2 * j + 2; e++) {
+            T w = (e == 2 * j) ? -(T)weight[j] : (T)weight[j];
+            qWeight(e) = w;
+            bSinWeight(e) = w * (m * bandsScaled[e] + c);
+            bCosWeight(e) = w * m;
+        }
     }
+}
+
+/*
+ * Assemble the folded matrix, our sum of Toeplitz and Hankel
+ * Q1 = toeplitz(q[:M+1])
+ * Q2 = hankel(q[:M+1], q[M:])
+ * Q = Q1 + Q2
+ * For antisymmetric filters the Hankel part is subtracted, and for type III
+ * the row and column of the (zero) middle tap are dropped.
+ */
+template <typename T>
+static Matrix<T> foldedMatrix(const T q[], int numTaps, bool antisymmetric = false,
+                              int threads = 1) {
     int M = (numTaps - 1) / 2;
     bool isType2 = (numTaps % 2 == 0);
+    bool isType3 = antisymmetric && !isType2;
+    int size = isType3 ? M : M + 1;
+    int offset = isType2 ? 1 : (isType3 ? 2 : 0);
+    T sign = antisymmetric ? T(-1) : T(1);
+    Matrix<T> Q(size, size);
+    // column by column, every thread fills its own columns
+#ifdef FIR_OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1)
+#endif
+    for (int j = 0; j < size; j++) {
+        for (int i = 0; i < size; i++) {
+            // Toeplitz
+            int t_index = (i >= j) ? (i - j) : (j - i);
+            T t = q[t_index];
+            // Hankel
+            int h_index = i + j + offset;
+            T h = q[h_index];
+            Q(i, j) = t + sign * h;
+        }
+    }
+    return Q;
+}
 
-    FirFloat nyq = 0.5 * fs;
-    if (nyq <= 0.0) {
-        return FIR_EFREQUENCY;
+/* Taps of the filter from the solution a of the folded system */
+template <typename T, typename In>
+static void foldedToTaps(In result[], const Vector<T> &a, int numTaps,
+                         bool antisymmetric = false) {
+    int M = (numTaps - 1) / 2;
+    if (antisymmetric) {
+        // make coefficients antisymmetric
+        if (numTaps % 2 == 1) {
+            // type III filter - middle coefficient is zero
+            result[M] = 0;
+            for (int i = 1; i <= M; i++) {
+                result[M - i] = (In)a(i - 1);
+                result[M + i] = (In)(-a(i - 1));
+            }
+        } else {
+            // type IV filter
+            for (int i = 0; i <= M; i++) {
+                result[M - i] = (In)a(i);
+                result[M + i + 1] = (In)(-a(i));
+            }
+        }
+        return;
+    }
+    // make coefficients symmetric (linear phase)
+    if (numTaps % 2 == 1) {
+        // type I filter - middle coefficient is doubled
+        result[M] = (In)(2 * a(0));
+        for (int i = 1; i <= M; i++) {
+            result[M + i] = result[M - i] = (In)a(i);
+        }
+    } else {
+        // type II filter
+        for (int i = 0; i <= M; i++) {
+            result[M + i + 1] = result[M - i] = (In)a(i);
+        }
     }
+}
 
-    // Scale the frequency bands relative to nyquist, and check if frequencies are in range 0-1
-    if (numBands <= 0) {
-        return FIR_ENUMBANDS;
+/*
+ * Threshold on the estimated condition number of the folded matrix, above
+ * which the LDLT solution is rejected. LDLT is backward stable, so unlike
+ * Levinson it is accepted up to where the complete orthogonal decomposition
+ * would still consider Q of full rank, and give the same solution.
+ */
+static constexpr double LDLT_MAX_CONDITION = 1e12;
+
+template <typename T> static T ldltMaxCondition() {
+    return (T)LDLT_MAX_CONDITION *
+           ((T)std::numeric_limits<double>::epsilon() / std::numeric_limits<T>::epsilon());
+}
+
+/*
+ * Condition number of the folded matrix estimated from its LDLT decomposition,
+ * infinite if the matrix is not (numerically) positive definite.
+ */
+template <typename T> static T ldltCondition(const Eigen::LDLT<Matrix<T>> &ldlt) {
+    if (ldlt.info() != Eigen::Success || !ldlt.isPositive() || !(ldlt.rcond() > 0)) {
+        return std::numeric_limits<T>::infinity();
     }
-    FirFloat bands_scaled[2 * numBands];
-    for (int i = 0; i < 2 * numBands; i++) {
-        bands_scaled[i] = bands[i] / nyq;
-        if (bands_scaled[i] < 0 || bands_scaled[i] > 1) {
-            return FIR_EBANDS;
+    return 1 / ldlt.rcond();
+}
+
+static void setStats(FirlsStats *stats, int solver, double condition) {
+    if (stats != NULL) {
+        stats->solver = solver;
+        stats->condition = (FirFloat)condition;
+    }
+}
+
+/*
+ * Solve the normal equations of a design from q and b, see design().
+ *
+ * @param d, x Room for numTaps values
+ * @param scratch Room for 5 * numTaps values
+ */
+template <typename T, typename In>
+static void solveNormalEquations(In result[], int numTaps, const T q[], const VectorMap<T> &b,
+                                 T d[], T x[], T scratch[], FirlsStats *stats,
+                                 bool antisymmetric) {
+    int M = (numTaps - 1) / 2;
+    bool isType2 = (numTaps % 2 == 0);
+
+    // The matrix Q is the folded form of the normal equations of the
+    // unconstrained problem: minimize ∫W(ω)|H(ω)e^(jω(numTaps-1)/2) - D(ω)|² over all
+    // (not necessarily symmetric) h of length numTaps. These normal equations
+    // are T h = d, with T = toeplitz(q[:numTaps]) and d the mirrored b. T is
+    // persymmetric and d is symmetric, so the unique solution is symmetric,
+    // and equal to the solution of Qa = b. A symmetric positive definite
+    // Toeplitz system is solved in O(numTaps²) with the Levinson recursion,
+    // instead of O(M³) for a dense decomposition of Q.
+    // For antisymmetric filters d is the antisymmetric mirror of b, and so is
+    // the solution: the same T serves all four filter types.
+    T sign = antisymmetric ? T(-1) : T(1);
+    for (int i = 0; i < numTaps; i++) {
+        int b_index = (i > M) ? (i - M - (isType2 ? 1 : 0)) : (M - i);
+        d[i] = (i > M) ? sign * b(b_index) : b(b_index);
+    }
+    T condition = std::numeric_limits<T>::infinity();
+    if (firSolveToeplitz(x, numTaps, q, d, scratch, &condition)) {
+        // enforce exact (anti)symmetry, the recursion gives it only up to rounding
+        for (int i = 0; i < numTaps; i++) {
+            result[i] = (In)(T(0.5) * (x[i] + sign * x[numTaps - 1 - i]));
         }
+        setStats(stats, FIR_SOLVER_LEVINSON, (double)condition);
+        return;
     }
 
-    // Check if frequency bands are non-zero width, monotonically increasing
-    for (int i = 0; i < numBands; i++) {
-        if (bands_scaled[2 * i + 1] <= bands_scaled[2 * i]) {
-            return FIR_EBANDS;
+    // Levinson failed: T is ill-conditioned or (numerically) rank deficient.
+    // The folded matrix Q only has the eigenvalues of T for the symmetric
+    // eigenvectors, so it can be better conditioned than T. Moreover LDLT is
+    // backward stable, so it tolerates a larger condition number: try a LDLT
+    // decomposition of Q before the rank revealing decomposition.
+    const int threads = designThreads(numTaps);
+    Matrix<T> Q = foldedMatrix(q, numTaps, antisymmetric, threads);
+    // type III: without b(0), the zero middle tap
+    Vector<T> rhs = b.tail(Q.rows());
+    if (threads > 1) {
+        // Eigen has no parallel LDLT, but its blocked LU runs on all threads.
+        // LU with partial pivoting is also backward stable, at twice the
+        // operations of LDLT.
+        Eigen::PartialPivLU<Matrix<T>> lu(Q);
+        condition = (lu.rcond() > 0) ? 1 / lu.rcond() : std::numeric_limits<T>::infinity();
+        if (condition < ldltMaxCondition<T>()) {
+            Vector<T> a = lu.solve(rhs);
+            foldedToTaps(result, a, numTaps, antisymmetric);
+            setStats(stats, FIR_SOLVER_LU, (double)condition);
+            return;
         }
-        if (i > 0 && bands_scaled[2 * i] < bands_scaled[2 * i - 1]) {
-            return FIR_EBANDS;
+    } else {
+        Eigen::LDLT<Matrix<T>> ldlt(Q);
+        condition = ldltCondition(ldlt);
+        if (condition < ldltMaxCondition<T>()) {
+            Vector<T> a = ldlt.solve(rhs);
+            foldedToTaps(result, a, numTaps, antisymmetric);
+            setStats(stats, FIR_SOLVER_LDLT, (double)condition);
+            return;
         }
     }
 
-    // SciPy signal.firls rejects negative values of desired. The algorithm does
-    // seem to work correctly for negative values, so we don't check.
+    // SciPy firls starts with lapack posv (= Cholesky) and falls back to gelsy (QR with column
+    // pivoting) if this fails.
 
-    // Check if weight is positive
-    for (int i = 0; i < numBands; i++) {
-        if (weight[i] < 0) {
-            return FIR_EWEIGHTS;
-        }
+    // Here we first try the Levinson recursion on the equivalent Toeplitz
+    // system (see above), then LDLT on Q, and only for rank deficient systems
+    // we do a complete orthogonal decomposition. See the
+    // recommendation in https://eigen.tuxfamily.org/dox/group__LeastSquares.html
+    // Speed comparison, WebAssembly, 1001 taps: 91 ms for
+    // CompleteOrthogonalDecomposition vs 77 ms for ColPivHouseholderQR, with
+    // CompleteOrthogonalDecompostion having much improved stability for filters
+    // with too many taps.
+    Eigen::CompleteOrthogonalDecomposition<Eigen::Ref<Matrix<T>>> od(Q);
+    Vector<T> a = od.solve(rhs);
+    foldedToTaps(result, a, numTaps, antisymmetric);
+    setStats(stats, FIR_SOLVER_COD, (double)condition);
+#if 0
+    for (int i = 0; i < numTaps; i++) {
+        printf("result(%d): %lf\n", i, result[i]);
+    }
+#endif
+}
+
+/*
+ * firls_ws calculated with scalar type T, for arguments and result of type In.
+ */
+template <typename T, typename In>
+static int design(In result[], int numTaps, int numBands, const In bands[],
+                  const In desiredBegin[], const In desiredEnd[], const In weight[], In fs,
+                  void *workspace, size_t workspaceSize, FirlsStats *stats,
+                  bool antisymmetric) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    int M = (numTaps - 1) / 2;
+    bool isType2 = (numTaps % 2 == 0);
+
+    T nyq = T(0.5) * fs;
+    if (nyq <= 0.0) {
+        return FIR_EFREQUENCY;
+    }
+
+    if (numBands <= 0) {
+        return FIR_ENUMBANDS;
+    }
+    Workspace ws(workspace, workspaceSize);
+    FirlsBuffers<T> buffers;
+    if (workspace == NULL || !buffers.allocate(ws, numTaps, numBands)) {
+        return FIR_EWORKSPACE;
+    }
+    T *bands_scaled = buffers.bandsScaled;
+    int error = firScaleBands(bands_scaled, numBands, bands, weight, nyq);
+    if (error != 0) {
+        return error;
     }
 
     // Set up the linear matrix equation to be solved, Qa = b
@@ -76,36 +469,7 @@ int firls(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
     // interval f1->f2 we get:
     //     q(n) = W∫cos(πnf)df (0->1) = Wf sin(πnf)/πnf
     // integrated over each f1->f2 pair (i.e., value at f2 - value at f1).
-    FirFloat q[numTaps];
-    for (int i = 0; i < numTaps; i++) {
-        q[i] = 0.0;
-        for (int j = 0; j < numBands; j++) {
-            q[i] += (sinc(i * bands_scaled[2 * j + 1]) * bands_scaled[2 * j + 1] -
-                     sinc(i * bands_scaled[2 * j]) * bands_scaled[2 * j]) *
-                    weight[j];
-        }
-        // printf("q(%d): %lf\n", i, q[i]);
-    }
-    // Now we assemble our sum of Toeplitz and Hankel
-    // Q1 = toeplitz(q[:M+1])
-    // Q2 = hankel(q[:M+1], q[M:])
-    // Q = Q1 + Q2
-    Matrix Q = Matrix::Zero(M + 1, M + 1);
-    for (int i = 0; i <= M; i++) {
-        for (int j = 0; j <= M; j++) {
-            // Toeplitz
-            int t_index = (i >= j) ? (i - j) : (j - i);
-            FirFloat t = q[t_index];
-            // Hankel
-            int h_index = i + j + (isType2 ? 1 : 0);
-            FirFloat h = q[h_index];
-            Q(i, j) = t + h;
-            // printf("Q1(%d,%d): %lf\n", i, j, t);
-            // printf("Q2(%d,%d): %lf\n", i, j, h);
-            // printf("Q(%d,%d): %lf\n", i, j, Q(i,j));
-        }
-    }
-
+    //
     // Now for b(n) we have that:
     //     b(n) = 1/π ∫ W(ω)D(ω)cos(nω)dω (over 0->π)
     // Using our normalization ω=πf and with a constant weight W over each
@@ -113,96 +477,894 @@ int firls(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
     //     b(n) = W ∫ (mf+c)cos(πnf)df
     //          = W [f(mf+c)sin(πnf)/πnf + mf**2 cos(nπf)/(πnf)**2]
     // integrated over each f1->f2 pair (i.e., value at f2 - value at f1).
+    //
+    // Both are sums over all band edges, of sin(πnf) and cos(πnf) times a
+    // per edge weight: -W at f1 and W at f2 for q, times (mf+c) and m for b.
+    // EdgeAngles evaluates sin and cos for all edges at once, so every sum is
+    // a dot product.
+    //
+    // Antisymmetric (type III and IV) filters have the amplitude response
+    // Σ a(n)sin(nω) instead, so Q(k,n) = q(k-n) - q(k+n), i.e. a Toeplitz
+    // minus Hankel with the same q, and
+    //     b(n) = W ∫ (mf+c)sin(πnf)df
+    //          = W [-(mf+c)cos(πnf)/πn + m sin(πnf)/(πn)**2]
+    // with the same per edge weights. For type III b(0) = 0.
+    const int numEdges = 2 * numBands;
+    Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> edges(bands_scaled, numEdges);
+    ArrayMap<T> qWeight(buffers.qWeight, numEdges);
+    ArrayMap<T> bSinWeight(buffers.bSinWeight, numEdges);
+    ArrayMap<T> bCosWeight(buffers.bCosWeight, numEdges);
+    edgeWeights(qWeight, bSinWeight, bCosWeight, numBands, bands_scaled, desiredBegin, desiredEnd,
+                weight);
 
-    FirFloat m[numBands];
-    FirFloat c[numBands];
-    // Choose m and c such that we are at the start and end weights
-    for (int i = 0; i < numBands; i++) {
-        m[i] = (desiredEnd[i] - desiredBegin[i]) / (bands_scaled[2 * i + 1] - bands_scaled[2 * i]);
-        c[i] = desiredBegin[i] - bands_scaled[2 * i] * m[i];
+    // n = 0: sin(πnf)/πn = f, and for type I the cos term with L'Hopital's
+    // rule: b[0] -= m * bands * bands / 2
+    T *q = buffers.q;
+    VectorMap<T> b(buffers.b, M + 1);
+    q[0] = (qWeight * edges).sum();
+    if (!isType2) {
+        b(0) = antisymmetric ? T(0) : (edges * (bSinWeight - T(0.5) * bCosWeight * edges)).sum();
     }
-
-    Vector b = Vector::Zero(M + 1);
-    FirFloat halfExtra = (isType2 ? 0.5 : 0.0);
-    for (int i = 0; i <= M; i++) {
-        for (int j = 0; j < numBands; j++) {
-            b(i) += (bands_scaled[2 * j + 1] * (m[j] * bands_scaled[2 * j + 1] + c[j]) *
-                         sinc((i + halfExtra) * bands_scaled[2 * j + 1]) -
-                     bands_scaled[2 * j] * (m[j] * bands_scaled[2 * j] + c[j]) *
-                         sinc((i + halfExtra) * bands_scaled[2 * j])) *
-                    weight[j];
+    EdgeAngles<T> angles(buffers.angles, bands_scaled, numEdges, 0.0);
+    for (int i = 1; i < numTaps; i++) {
+        angles.next();
+        T scale = i * pi<T>();
+        q[i] = (qWeight * angles.sin).sum() / scale;
+        if (!isType2 && i <= M) {
+            if (antisymmetric) {
+                b(i) = -(bSinWeight * angles.cos).sum() / scale +
+                       (bCosWeight * angles.sin).sum() / (scale * scale);
+            } else {
+                b(i) = (bSinWeight * angles.sin).sum() / scale +
+                       (bCosWeight * angles.cos).sum() / (scale * scale);
+            }
         }
     }
-#if 0
-    for (int i = 0; i<= M; i++) {
-        printf("before - b(%d): %lf\n", i, b(i));
-    }
-#endif
-    /*
-     * Only for type I filter: coefficient 0 is special, would give division by zero with normal
-     * formula. Use L'Hopital's rule here for cos(nπf)/(πnf)**2 @ n=0 b[0] -= m * bands * bands / 2.
-     */
-    if (!isType2) {
-        for (int j = 0; j < numBands; j++) {
-            b(0) -= 0.5 * m[j] *
-                    (bands_scaled[2 * j + 1] * bands_scaled[2 * j + 1] -
-                     bands_scaled[2 * j] * bands_scaled[2 * j]) *
-                    weight[j];
-        }
-    }
-    /*
-     * b[1:] += m * np.cos(n[1:] * np.pi * bands) / (np.pi * n[1:]) ** 2
-     * b = np.dot(np.diff(b, axis=2)[:, :, 0], weight)
-     */
-    int startIndex = isType2 ? 0 : 1;
-    for (int i = startIndex; i <= M; i++) {
-        for (int j = 0; j < numBands; j++) {
-            FirFloat scale = (i + halfExtra) * PI;
-            FirFloat scale_squared = scale * scale;
-            FirFloat c1 = cos(scale * bands_scaled[2 * j]) / scale_squared;
-            FirFloat c2 = cos(scale * bands_scaled[2 * j + 1]) / scale_squared;
-            b(i) += m[j] * (c2 - c1) * weight[j];
+    if (isType2) {
+        // type II: b at the angles π(n + 0.5)f
+        EdgeAngles<T> halfAngles(buffers.angles, bands_scaled, numEdges, 0.5);
+        for (int i = 0; i <= M; i++) {
+            if (i > 0) {
+                halfAngles.next();
+            }
+            T scale = (i + T(0.5)) * pi<T>();
+            if (antisymmetric) {
+                b(i) = -(bSinWeight * halfAngles.cos).sum() / scale +
+                       (bCosWeight * halfAngles.sin).sum() / (scale * scale);
+            } else {
+                b(i) = (bSinWeight * halfAngles.sin).sum() / scale +
+                       (bCosWeight * halfAngles.cos).sum() / (scale * scale);
+            }
         }
     }
 #if 0
-    for (int i = 0; i<= M; i++) {
-        printf("after - b(%d): %lf\n", i, b(i));
+    for (int i = 0; i <= M; i++) {
+        printf("b(%d): %lf\n", i, b(i));
     }
 #endif
 
-    // SciPy firls starts with lapack posv (= LU) and falls back to gelsy (QR with column pivoting)
-    // if this fails.
+    solveNormalEquations(result, numTaps, q, b, buffers.d, buffers.x, buffers.scratch, stats,
+                         antisymmetric);
+    return 0;
+}
 
-    // Here we do always complete orthogonal decomposition. See the
-    // recommendation in https://eigen.tuxfamily.org/dox/group__LeastSquares.html
-    // Speed comparison, WebAssembly, 1001 taps: 91 ms for
-    // CompleteOrthogonalDecomposition vs 77 ms for ColPivHouseholderQR, with
-    // CompleteOrthogonalDecompostion having much improved stability for filters
-    // with too many taps.
-#if 0
-    Eigen::ColPivHouseholderQR<Eigen::Ref<Eigen::MatrixXd>> qr(Q);
-    Vector a = qr.solve(b);
+int firls_set_num_threads(int threads) {
+#ifdef FIR_OPENMP
+    const int count = (threads > 0) ? threads : omp_get_num_procs();
+    Eigen::setNbThreads(count);
+#else
+    (void)threads;
+    const int count = 1;
 #endif
-    Eigen::CompleteOrthogonalDecomposition<Eigen::Ref<Eigen::MatrixXd>> od(Q);
-    Vector a = od.solve(b);
+    numThreads.store(count);
+    return count;
+}
 
-    // make coefficients symmetric (linear phase)
+size_t firls_workspace_size(int numTaps, int numBands) {
+    return workspaceSize<FirFloat>(numTaps, numBands);
+}
+
+int firls_ws(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+             const FirFloat desiredBegin[], const FirFloat desiredEnd[], const FirFloat weight[],
+             FirFloat fs, void *workspace, size_t workspaceSize) {
+    return design<FirFloat>(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight, fs,
+                            workspace, workspaceSize, NULL, false);
+}
+
+int firls(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+          const FirFloat desiredBegin[], const FirFloat desiredEnd[], const FirFloat weight[],
+          FirFloat fs) {
+    // heap allocated workspace: large designs do not fit on the stack
+    std::vector<char> workspace(firls_workspace_size(numTaps, numBands));
+    return firls_ws(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight, fs,
+                    workspace.data(), workspace.size());
+}
+
+int firls_stats(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+                const FirFloat desiredBegin[], const FirFloat desiredEnd[], const FirFloat weight[],
+                FirFloat fs, FirlsStats *stats) {
+    std::vector<char> workspace(firls_workspace_size(numTaps, numBands));
+    return design<FirFloat>(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight, fs,
+                            workspace.data(), workspace.size(), stats, false);
+}
+
+int firls_antisymmetric(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+                        const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                        const FirFloat weight[], FirFloat fs) {
+    std::vector<char> workspace(firls_workspace_size(numTaps, numBands));
+    return design<FirFloat>(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight, fs,
+                            workspace.data(), workspace.size(), NULL, true);
+}
+
+int firls_f(float result[], int numTaps, int numBands, const float bands[],
+            const float desiredBegin[], const float desiredEnd[], const float weight[], float fs) {
+    std::vector<char> workspace(workspaceSize<double>(numTaps, numBands));
+    return design<double>(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight, fs,
+                          workspace.data(), workspace.size(), NULL, false);
+}
+
+int firls_l(long double result[], int numTaps, int numBands, const long double bands[],
+            const long double desiredBegin[], const long double desiredEnd[],
+            const long double weight[], long double fs) {
+    std::vector<char> workspace(workspaceSize<long double>(numTaps, numBands));
+    return design<long double>(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight,
+                               fs, workspace.data(), workspace.size(), NULL, false);
+}
+
+/*
+ * Q only depends on the bands, the weights and fs, and b is linear in the
+ * per edge weights of the desired response:
+ *     b = bSin^T * bSinWeight + bCos^T * bCosWeight
+ * with bSin(e, n) = sin(πnf)/πn and bCos(e, n) = cos(πnf)/(πn)² for band
+ * edge e at frequency f (for type II at n + 0.5, type I n = 0 see design()).
+ * The designer caches the factorization of Q and the matrices bSin and bCos
+ * for the bands, weights and fs of the last design.
+ */
+struct FirlsDesigner {
+    int numTaps;
+    bool cached;
+
+    // specification of the cache
+    std::vector<FirFloat> bands;
+    std::vector<FirFloat> weight;
+    FirFloat fs;
+
+    std::vector<FirFloat> bandsScaled;
+    Matrix<FirFloat> bSin;
+    Matrix<FirFloat> bCos;
+    // solver for Q, as firls: FIR_SOLVER_LEVINSON, FIR_SOLVER_LDLT or FIR_SOLVER_COD
+    int solver;
+    FirFloat condition;
+    // Levinson: q, the first column of the Toeplitz matrix, and its reflection coefficients
+    std::vector<FirFloat> q;
+    std::vector<FirFloat> reflection;
+    // only computed when the Levinson recursion fails
+    Eigen::LDLT<Matrix<FirFloat>> ldlt;
+    Eigen::CompleteOrthogonalDecomposition<Matrix<FirFloat>> cod;
+
+    // per design
+    Vector<FirFloat> edgeWeights; // 3 * 2 * numBands: q, bSin and bCos weights
+    Vector<FirFloat> b;
+    Vector<FirFloat> a;
+    std::vector<FirFloat> d;       // numTaps, mirrored b
+    std::vector<FirFloat> x;       // numTaps, Levinson solution
+    std::vector<FirFloat> scratch; // 5 * numTaps, Levinson recursion
+};
+
+static bool sameSpecification(const FirlsDesigner *designer, int numBands, const FirFloat bands[],
+                              const FirFloat weight[], FirFloat fs) {
+    return designer->cached && designer->fs == fs &&
+           designer->weight.size() == (size_t)numBands &&
+           std::equal(designer->bands.begin(), designer->bands.end(), bands) &&
+           std::equal(designer->weight.begin(), designer->weight.end(), weight);
+}
+
+/*
+ * Calculate q, bSin and bCos and factorize Q with the same solvers as firls:
+ * the reflection coefficients of the Levinson recursion, and only if the
+ * recursion fails a LDLT decomposition of Q, or for an ill-conditioned Q a
+ * complete orthogonal decomposition. Whether the recursion succeeds only
+ * depends on Q, not on the desired response.
+ */
+static void updateCache(FirlsDesigner *designer, int numBands, const FirFloat desiredBegin[],
+                        const FirFloat desiredEnd[], const FirFloat weight[]) {
+    const int numTaps = designer->numTaps;
+    const int M = (numTaps - 1) / 2;
+    const bool isType2 = (numTaps % 2 == 0);
+    const int numEdges = 2 * numBands;
+    const FirFloat *edges = designer->bandsScaled.data();
+    Eigen::Map<const Eigen::Array<FirFloat, Eigen::Dynamic, 1>> edgeArray(edges, numEdges);
+
+    designer->edgeWeights.resize(3 * numEdges);
+    ArrayMap<FirFloat> qWeight(designer->edgeWeights.data(), numEdges);
+    ArrayMap<FirFloat> bSinWeight(designer->edgeWeights.data() + numEdges, numEdges);
+    ArrayMap<FirFloat> bCosWeight(designer->edgeWeights.data() + 2 * numEdges, numEdges);
+    edgeWeights(qWeight, bSinWeight, bCosWeight, numBands, edges, desiredBegin, desiredEnd, weight);
+
+    std::vector<FirFloat> &q = designer->q;
+    q.resize(numTaps);
+    Matrix<FirFloat> &bSin = designer->bSin;
+    Matrix<FirFloat> &bCos = designer->bCos;
+    bSin.resize(numEdges, M + 1);
+    bCos.resize(numEdges, M + 1);
+    std::vector<FirFloat> angleBuffer(EdgeAngles<FirFloat>::BUFFER_SIZE * numEdges);
+
+    q[0] = (qWeight * edgeArray).sum();
     if (!isType2) {
-        // type I filter - middle coefficient is doubled
-        result[M] = 2 * a(0);
-        for (int i = 1; i <= M; i++) {
-            result[M + i] = result[M - i] = a(i);
+        bSin.col(0) = edgeArray;
+        bCos.col(0) = -0.5 * edgeArray * edgeArray;
+    }
+    EdgeAngles<FirFloat> angles(angleBuffer.data(), edges, numEdges, 0.0);
+    for (int i = 1; i < numTaps; i++) {
+        angles.next();
+        FirFloat scale = i * pi<FirFloat>();
+        q[i] = (qWeight * angles.sin).sum() / scale;
+        if (!isType2 && i <= M) {
+            bSin.col(i) = angles.sin / scale;
+            bCos.col(i) = angles.cos / (scale * scale);
         }
-    } else {
-        // type II filter
+    }
+    if (isType2) {
+        EdgeAngles<FirFloat> halfAngles(angleBuffer.data(), edges, numEdges, 0.5);
         for (int i = 0; i <= M; i++) {
-            result[M + i + 1] = result[M - i] = a(i);
+            if (i > 0) {
+                halfAngles.next();
+            }
+            FirFloat scale = (i + 0.5) * pi<FirFloat>();
+            bSin.col(i) = halfAngles.sin / scale;
+            bCos.col(i) = halfAngles.cos / (scale * scale);
         }
     }
-#if 0
+
+    designer->b.resize(M + 1);
+    designer->a.resize(M + 1);
+    designer->b.noalias() = bSin.transpose() * bSinWeight.matrix();
+    designer->b.noalias() += bCos.transpose() * bCosWeight.matrix();
+    designer->d.resize(numTaps);
+    designer->x.resize(numTaps);
+    designer->scratch.resize(5 * (size_t)numTaps);
+    designer->reflection.resize(numTaps);
     for (int i = 0; i < numTaps; i++) {
-        printf("result(%d): %lf\n", i, result[i]);
+        int b_index = (i > M) ? (i - M - (isType2 ? 1 : 0)) : (M - i);
+        designer->d[i] = designer->b(b_index);
     }
-#endif
+    FirFloat condition = std::numeric_limits<FirFloat>::infinity();
+    if (firSolveToeplitz(designer->x.data(), numTaps, q.data(), designer->d.data(),
+                         designer->scratch.data(), &condition, designer->reflection.data())) {
+        designer->solver = FIR_SOLVER_LEVINSON;
+        designer->condition = condition;
+        return;
+    }
+
+    Matrix<FirFloat> Q = foldedMatrix(q.data(), numTaps, false, designThreads(numTaps));
+    designer->ldlt.compute(Q);
+    designer->condition = ldltCondition(designer->ldlt);
+    if (designer->condition < ldltMaxCondition<FirFloat>()) {
+        designer->solver = FIR_SOLVER_LDLT;
+    } else {
+        designer->solver = FIR_SOLVER_COD;
+        designer->cod.compute(Q);
+    }
+}
+
+/*
+ * Taps for the right hand side b of the folded system, with the cached
+ * factorization.
+ */
+template <typename Derived>
+static void solveCached(FirlsDesigner *designer, FirFloat result[],
+                        const Eigen::MatrixBase<Derived> &b) {
+    const int numTaps = designer->numTaps;
+    if (designer->solver == FIR_SOLVER_LEVINSON) {
+        // see solveNormalEquations()
+        const int M = (numTaps - 1) / 2;
+        const bool isType2 = (numTaps % 2 == 0);
+        FirFloat *d = designer->d.data();
+        FirFloat *x = designer->x.data();
+        for (int i = 0; i < numTaps; i++) {
+            int b_index = (i > M) ? (i - M - (isType2 ? 1 : 0)) : (M - i);
+            d[i] = b(b_index);
+        }
+        firSolveToeplitzReflection(x, numTaps, designer->q.data(), designer->reflection.data(), d,
+                                   designer->scratch.data());
+        for (int i = 0; i < numTaps; i++) {
+            result[i] = 0.5 * (x[i] + x[numTaps - 1 - i]);
+        }
+        return;
+    }
+    if (designer->solver == FIR_SOLVER_COD) {
+        designer->a = designer->cod.solve(b);
+    } else {
+        designer->a = designer->ldlt.solve(b);
+    }
+    foldedToTaps(result, designer->a, numTaps);
+}
+
+FirlsDesigner *firls_designer_create(int numTaps) {
+    if (numTaps < 1) {
+        return NULL;
+    }
+    FirlsDesigner *designer = new FirlsDesigner;
+    designer->numTaps = numTaps;
+    designer->cached = false;
+    designer->fs = 0.0;
+    designer->solver = FIR_SOLVER_LEVINSON;
+    designer->condition = 0.0;
+    return designer;
+}
+
+/*
+ * Update the cache of the designer if the specification differs from the
+ * cached one.
+ *
+ * @returns 0 on success, error code on failure
+ */
+static int prepare(FirlsDesigner *designer, int numBands, const FirFloat bands[],
+                   const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                   const FirFloat weight[], FirFloat fs) {
+    const int numEdges = 2 * numBands;
+    if (!sameSpecification(designer, numBands, bands, weight, fs)) {
+        designer->cached = false;
+        FirFloat nyq = 0.5 * fs;
+        if (nyq <= 0.0) {
+            return FIR_EFREQUENCY;
+        }
+        if (numBands <= 0) {
+            return FIR_ENUMBANDS;
+        }
+        designer->bandsScaled.resize(numEdges);
+        int error = firScaleBands(designer->bandsScaled.data(), numBands, bands, weight, nyq);
+        if (error != 0) {
+            return error;
+        }
+        updateCache(designer, numBands, desiredBegin, desiredEnd, weight);
+        designer->bands.assign(bands, bands + numEdges);
+        designer->weight.assign(weight, weight + numBands);
+        designer->fs = fs;
+        designer->cached = true;
+    }
+    return 0;
+}
+
+int firls_designer_design(FirlsDesigner *designer, FirFloat result[], int numBands,
+                          const FirFloat bands[], const FirFloat desiredBegin[],
+                          const FirFloat desiredEnd[], const FirFloat weight[], FirFloat fs) {
+    if (designer == NULL) {
+        return FIR_ENUMTAPS;
+    }
+    int error = prepare(designer, numBands, bands, desiredBegin, desiredEnd, weight, fs);
+    if (error != 0) {
+        return error;
+    }
+    const int numEdges = 2 * numBands;
+
+    // only b changes: O(M * numBands) for b, O(M²) for the solution
+    ArrayMap<FirFloat> qWeight(designer->edgeWeights.data(), numEdges);
+    ArrayMap<FirFloat> bSinWeight(designer->edgeWeights.data() + numEdges, numEdges);
+    ArrayMap<FirFloat> bCosWeight(designer->edgeWeights.data() + 2 * numEdges, numEdges);
+    edgeWeights(qWeight, bSinWeight, bCosWeight, numBands, designer->bandsScaled.data(),
+                desiredBegin, desiredEnd, weight);
+    designer->b.noalias() = designer->bSin.transpose() * bSinWeight.matrix();
+    designer->b.noalias() += designer->bCos.transpose() * bCosWeight.matrix();
+    solveCached(designer, result, designer->b);
+    return 0;
+}
+
+int firls_designer_stats(const FirlsDesigner *designer, FirlsStats *stats) {
+    if (designer == NULL || !designer->cached) {
+        return -1;
+    }
+    setStats(stats, designer->solver, (double)designer->condition);
+    return 0;
+}
+
+void firls_designer_destroy(FirlsDesigner *designer) { delete designer; }
+
+int firls_multi(FirFloat result[], int numFilters, int numTaps, int numBands,
+                const FirFloat bands[], const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                const FirFloat weight[], FirFloat fs) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    if (numFilters <= 0) {
+        return 0;
+    }
+    FirlsDesigner *designer = firls_designer_create(numTaps);
+    int error = prepare(designer, numBands, bands, desiredBegin, desiredEnd, weight, fs);
+    if (error != 0) {
+        firls_designer_destroy(designer);
+        return error;
+    }
+
+    // one column of edge weights and of B per filter
+    const int numEdges = 2 * numBands;
+    Matrix<FirFloat> bSinWeights(numEdges, numFilters);
+    Matrix<FirFloat> bCosWeights(numEdges, numFilters);
+    for (int k = 0; k < numFilters; k++) {
+        ArrayMap<FirFloat> qWeight(designer->edgeWeights.data(), numEdges);
+        ArrayMap<FirFloat> bSinWeight(bSinWeights.col(k).data(), numEdges);
+        ArrayMap<FirFloat> bCosWeight(bCosWeights.col(k).data(), numEdges);
+        edgeWeights(qWeight, bSinWeight, bCosWeight, numBands, designer->bandsScaled.data(),
+                    desiredBegin + (size_t)k * (size_t)numBands,
+                    desiredEnd + (size_t)k * (size_t)numBands, weight);
+    }
+    Matrix<FirFloat> B = designer->bSin.transpose() * bSinWeights;
+    B.noalias() += designer->bCos.transpose() * bCosWeights;
+
+    // one factorization, a solve per column
+    if (designer->solver == FIR_SOLVER_LEVINSON) {
+        for (int k = 0; k < numFilters; k++) {
+            solveCached(designer, result + (size_t)k * (size_t)numTaps, B.col(k));
+        }
+    } else {
+        Matrix<FirFloat> A = (designer->solver == FIR_SOLVER_COD)
+                                 ? Matrix<FirFloat>(designer->cod.solve(B))
+                                 : Matrix<FirFloat>(designer->ldlt.solve(B));
+        for (int k = 0; k < numFilters; k++) {
+            foldedToTaps(result + (size_t)k * (size_t)numTaps, Vector<FirFloat>(A.col(k)),
+                         numTaps);
+        }
+    }
+    firls_designer_destroy(designer);
+    return 0;
+}
+
+/*
+ * q and b of firls_minorder for all numbers of taps up to size. Neither q(n)
+ * nor b(n) depend on the number of taps: b at n for type I, and at n + 0.5
+ * for type II.
+ */
+struct MinorderCache {
+    int size;
+    std::vector<FirFloat> bandsScaled;
+    std::vector<FirFloat> edgeWeights; // 3 * 2 * numBands: q, bSin and bCos weights
+    std::vector<FirFloat> angles;
+    std::vector<FirFloat> q;
+    std::vector<FirFloat> bType1;
+    std::vector<FirFloat> bType2;
+};
+
+static void fillCache(MinorderCache &cache, int numBands, int size) {
+    const int numEdges = 2 * numBands;
+    const FirFloat *edges = cache.bandsScaled.data();
+    Eigen::Map<const Eigen::Array<FirFloat, Eigen::Dynamic, 1>> edgeArray(edges, numEdges);
+    ArrayMap<FirFloat> qWeight(cache.edgeWeights.data(), numEdges);
+    ArrayMap<FirFloat> bSinWeight(cache.edgeWeights.data() + numEdges, numEdges);
+    ArrayMap<FirFloat> bCosWeight(cache.edgeWeights.data() + 2 * numEdges, numEdges);
+    const int half = size / 2 + 1;
+    cache.size = size;
+    cache.q.resize(size);
+    cache.bType1.resize(half);
+    cache.bType2.resize(half);
+
+    // see design()
+    cache.q[0] = (qWeight * edgeArray).sum();
+    cache.bType1[0] = (edgeArray * (bSinWeight - 0.5 * bCosWeight * edgeArray)).sum();
+    EdgeAngles<FirFloat> angles(cache.angles.data(), edges, numEdges, 0.0);
+    for (int i = 1; i < size; i++) {
+        angles.next();
+        FirFloat scale = i * pi<FirFloat>();
+        cache.q[i] = (qWeight * angles.sin).sum() / scale;
+        if (i < half) {
+            cache.bType1[i] = (bSinWeight * angles.sin).sum() / scale +
+                              (bCosWeight * angles.cos).sum() / (scale * scale);
+        }
+    }
+    EdgeAngles<FirFloat> halfAngles(cache.angles.data(), edges, numEdges, 0.5);
+    for (int i = 0; i < half; i++) {
+        if (i > 0) {
+            halfAngles.next();
+        }
+        FirFloat scale = (i + 0.5) * pi<FirFloat>();
+        cache.bType2[i] = (bSinWeight * halfAngles.sin).sum() / scale +
+                          (bCosWeight * halfAngles.cos).sum() / (scale * scale);
+    }
+}
+
+/*
+ * Checks designs of firls_minorder against the specification: the magnitude
+ * on a grid with at least 8 points per tap, and exactly at the band edges. The
+ * freqz plan is only recreated when a longer filter needs a denser grid.
+ */
+class MinorderCheck {
+  public:
+    MinorderCheck(int numBands, const FirFloat bands[], const FirFloat desiredBegin[],
+                  const FirFloat desiredEnd[], const FirFloat maxDeviation[], FirFloat fs)
+        : _plan(NULL), _numBands(numBands), _bands(bands), _desiredBegin(desiredBegin),
+          _desiredEnd(desiredEnd), _maxDeviation(maxDeviation), _fs(fs),
+          _edgeMagnitudes(2 * numBands) {}
+
+    ~MinorderCheck() { firfreqz_plan_destroy(_plan); }
+
+    bool passes(const FirFloat taps[], int numTaps) {
+        int n = 512;
+        while (n < 8 * numTaps) {
+            n *= 2;
+        }
+        if ((int)_frequencies.size() < n + 1) {
+            firfreqz_plan_destroy(_plan);
+            _plan = firfreqz_plan_create(n + 1);
+            _frequencies.resize(n + 1);
+            _magnitudes.resize(n + 1);
+        }
+        if (_plan == NULL ||
+            firfreqz_plan_execute(_plan, _frequencies.data(), _magnitudes.data(), numTaps, taps,
+                                  _fs) != 0 ||
+            firfreqz_points(_bands, _edgeMagnitudes.data(), 2 * _numBands, numTaps, taps, _fs) !=
+                0) {
+            return false;
+        }
+        for (int j = 0; j < _numBands; j++) {
+            for (int e = 2 * j; e <= 2 * j + 1; e++) {
+                if (!withinBand(j, _bands[e], _edgeMagnitudes[e])) {
+                    return false;
+                }
+            }
+        }
+        size_t j = 0;
+        for (size_t i = 0; i < _frequencies.size(); i++) {
+            while (j < (size_t)_numBands && _frequencies[i] > _bands[2 * j + 1]) {
+                j++;
+            }
+            if (j == (size_t)_numBands) {
+                break;
+            }
+            if (_frequencies[i] >= _bands[2 * j] && !withinBand((int)j, _frequencies[i],
+                                                                _magnitudes[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    bool withinBand(int j, FirFloat f, FirFloat magnitude) const {
+        FirFloat begin = _bands[2 * j];
+        FirFloat end = _bands[2 * j + 1];
+        FirFloat desired =
+            _desiredBegin[j] + (_desiredEnd[j] - _desiredBegin[j]) * (f - begin) / (end - begin);
+        return std::fabs(magnitude - std::fabs(desired)) <= _maxDeviation[j];
+    }
+
+    FirFreqzPlan *_plan;
+    int _numBands;
+    const FirFloat *_bands;
+    const FirFloat *_desiredBegin;
+    const FirFloat *_desiredEnd;
+    const FirFloat *_maxDeviation;
+    FirFloat _fs;
+    std::vector<FirFloat> _edgeMagnitudes;
+    std::vector<FirFloat> _frequencies;
+    std::vector<FirFloat> _magnitudes;
+};
+
+/*
+ * Number of taps of an equiripple low pass filter with pass band deviation
+ * deltaPass, stop band deviation deltaStop and transition band width
+ * (relative to fs), with Herrmann's formula (O. Herrmann, L. R. Rabiner,
+ * D. S. K. Chan, "Practical design rules for optimum finite impulse response
+ * low-pass digital filters", 1973). Least squares designs need somewhat more.
+ */
+static int herrmannNumTaps(FirFloat deltaPass, FirFloat deltaStop, FirFloat width) {
+    if (deltaPass < deltaStop) {
+        std::swap(deltaPass, deltaStop);
+    }
+    const FirFloat lp = std::log10(deltaPass);
+    const FirFloat ls = std::log10(deltaStop);
+    const FirFloat dInf = (5.309e-3 * lp * lp + 7.114e-2 * lp - 4.761e-1) * ls +
+                          (-2.66e-3 * lp * lp - 5.941e-1 * lp - 4.278e-1);
+    const FirFloat f = 11.01217 + 0.51244 * (lp - ls);
+    return (int)std::ceil(dInf / width - f * width + 1);
+}
+
+int firls_minorder(FirFloat result[], int maxTaps, int numBands, const FirFloat bands[],
+                   const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                   const FirFloat weight[], FirFloat fs, const FirFloat maxDeviation[],
+                   int *numTaps, int *numSolves) {
+    if (maxTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    FirFloat nyq = 0.5 * fs;
+    if (nyq <= 0.0) {
+        return FIR_EFREQUENCY;
+    }
+    if (numBands <= 0) {
+        return FIR_ENUMBANDS;
+    }
+    for (int j = 0; j < numBands; j++) {
+        if (!(maxDeviation[j] > 0)) {
+            return FIR_ESPEC;
+        }
+    }
+    // default weights: the same weighted deviation in all bands
+    std::vector<FirFloat> weights(numBands);
+    for (int j = 0; j < numBands; j++) {
+        weights[j] = (weight != NULL) ? weight[j] : 1 / maxDeviation[j];
+    }
+
+    const int numEdges = 2 * numBands;
+    MinorderCache cache;
+    cache.size = 0;
+    cache.bandsScaled.resize(numEdges);
+    int error = firScaleBands(cache.bandsScaled.data(), numBands, bands, weights.data(), nyq);
+    if (error != 0) {
+        return error;
+    }
+    cache.edgeWeights.resize(3 * numEdges);
+    cache.angles.resize(EdgeAngles<FirFloat>::BUFFER_SIZE * numEdges);
+    ArrayMap<FirFloat> qWeight(cache.edgeWeights.data(), numEdges);
+    ArrayMap<FirFloat> bSinWeight(cache.edgeWeights.data() + numEdges, numEdges);
+    ArrayMap<FirFloat> bCosWeight(cache.edgeWeights.data() + 2 * numEdges, numEdges);
+    edgeWeights(qWeight, bSinWeight, bCosWeight, numBands, cache.bandsScaled.data(), desiredBegin,
+                desiredEnd, weights.data());
+
+    // Type II filters have a zero at nyquist: with a nonzero desired response
+    // there, only odd numbers of taps can pass. Search index k is the number
+    // of taps, or for odd only (number of taps - 1) / 2.
+    const bool oddOnly = cache.bandsScaled[numEdges - 1] == 1.0 &&
+                         std::fabs(desiredEnd[numBands - 1]) > maxDeviation[numBands - 1];
+    auto tapsOf = [oddOnly](int k) { return oddOnly ? 2 * k + 1 : k; };
+    const int kMin = oddOnly ? 0 : 1;
+    const int kMax = oddOnly ? (maxTaps - 1) / 2 : maxTaps;
+
+    // initial estimate: narrowest transition band, smallest deviations of the
+    // pass and the stop bands
+    FirFloat width = 0.0;
+    FirFloat deltaPass = 1.0;
+    FirFloat deltaStop = 1.0;
+    for (int j = 0; j < numBands; j++) {
+        if (j > 0 && bands[2 * j] > bands[2 * j - 1]) {
+            FirFloat w = (bands[2 * j] - bands[2 * j - 1]) / fs;
+            width = (width == 0.0) ? w : std::min(width, w);
+        }
+        bool isStop = desiredBegin[j] == 0.0 && desiredEnd[j] == 0.0;
+        FirFloat &delta = isStop ? deltaStop : deltaPass;
+        delta = std::min(delta, maxDeviation[j]);
+    }
+    int estimate = (width > 0.0) ? herrmannNumTaps(deltaPass, deltaStop, width) : 15;
+    int k = std::min(std::max(oddOnly ? (estimate - 1) / 2 : estimate, kMin), kMax);
+
+    std::vector<FirFloat> taps(maxTaps);
+    std::vector<FirFloat> d(maxTaps);
+    std::vector<FirFloat> x(maxTaps);
+    std::vector<FirFloat> scratch(5 * (size_t)maxTaps);
+    MinorderCheck check(numBands, bands, desiredBegin, desiredEnd, maxDeviation, fs);
+    int solves = 0;
+    int best = -1;
+    auto passes = [&](int index) {
+        const int n = tapsOf(index);
+        if (n > cache.size) {
+            // grow geometrically, the search doubles the number of taps
+            fillCache(cache, numBands, std::min(std::max(n, 2 * cache.size), maxTaps));
+        }
+        std::vector<FirFloat> &bHalf = (n % 2 == 1) ? cache.bType1 : cache.bType2;
+        VectorMap<FirFloat> b(bHalf.data(), (n - 1) / 2 + 1);
+        solveNormalEquations(taps.data(), n, cache.q.data(), b, d.data(), x.data(),
+                             scratch.data(), (FirlsStats *)NULL, false);
+        solves++;
+        if (!check.passes(taps.data(), n)) {
+            return false;
+        }
+        // the search only tries smaller designs after a pass
+        std::copy(taps.begin(), taps.begin() + n, result);
+        best = n;
+        return true;
+    };
+
+    // bracket the minimum between a failing lo and a passing hi
+    int lo = kMin - 1;
+    int hi;
+    if (passes(k)) {
+        hi = k;
+        for (int next = k / 2; next >= kMin && next < hi; next /= 2) {
+            if (!passes(next)) {
+                lo = next;
+                break;
+            }
+            hi = next;
+        }
+    } else {
+        lo = k;
+        hi = -1;
+        while (hi < 0 && lo < kMax) {
+            int next = std::min(2 * lo + 1, kMax);
+            if (passes(next)) {
+                hi = next;
+            } else {
+                lo = next;
+            }
+        }
+    }
+    while (hi > 0 && hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        if (passes(mid)) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    if (numTaps != NULL) {
+        *numTaps = best;
+    }
+    if (numSolves != NULL) {
+        *numSolves = solves;
+    }
+    return (best < 0) ? FIR_ESPEC : 0;
+}
+
+/*
+ * Grid of firls_sampled: at least SAMPLED_GRID_PER_TAP grid steps per tap,
+ * and SAMPLED_GRID_PER_POINT per point of the curve.
+ */
+static constexpr int SAMPLED_GRID_PER_TAP = 16;
+static constexpr int SAMPLED_GRID_PER_POINT = 4;
+static constexpr int SAMPLED_GRID_MIN = 1024;
+
+/*
+ * Weight and weight times desired of the piecewise linear curve of
+ * firls_sampled, at the grid f = j / gridSize (relative to nyquist). Outside
+ * the curve the weight is zero. At a discontinuity (a repeated frequency) on
+ * a grid point, the grid value is the mean of the left and right limits.
+ */
+static void sampleCurve(FirFloat w[], FirFloat wd[], int gridSize, int numPoints,
+                        const FirFloat points[], const FirFloat desired[],
+                        const FirFloat weight[]) {
+    int i = 0;
+    for (int j = 0; j <= gridSize; j++) {
+        FirFloat f = (FirFloat)j / gridSize;
+        while (i < numPoints && points[i] < f) {
+            i++;
+        }
+        if (i < numPoints && points[i] == f) {
+            int last = i;
+            while (last + 1 < numPoints && points[last + 1] == f) {
+                last++;
+            }
+            // left limit at the first point at f, right limit at the last,
+            // zero outside the curve
+            FirFloat wLeft = (i > 0) ? weight[i] : 0.0;
+            FirFloat wdLeft = wLeft * desired[i];
+            FirFloat wRight = (last < numPoints - 1) ? weight[last] : 0.0;
+            FirFloat wdRight = wRight * desired[last];
+            if (j == 0) {
+                w[j] = wRight;
+                wd[j] = wdRight;
+            } else if (j == gridSize) {
+                w[j] = wLeft;
+                wd[j] = wdLeft;
+            } else {
+                w[j] = 0.5 * (wLeft + wRight);
+                wd[j] = 0.5 * (wdLeft + wdRight);
+            }
+        } else if (i == 0 || i == numPoints) {
+            w[j] = 0.0;
+            wd[j] = 0.0;
+        } else {
+            FirFloat t = (f - points[i - 1]) / (points[i] - points[i - 1]);
+            FirFloat wf = weight[i - 1] + t * (weight[i] - weight[i - 1]);
+            w[j] = wf;
+            wd[j] = wf * (desired[i - 1] + t * (desired[i] - desired[i - 1]));
+        }
+    }
+}
+
+/*
+ * Cosine moments of the piecewise linear interpolation L of g on the grid
+ * f = j / gridSize:
+ *     moments(n) = ∫ L(f)cos(πkf/2)df (0->1), k = 2n + offset
+ * so q(n) and b(n) of type I have offset 0, and b(n) of type II offset 1.
+ * L is a sum of hat functions, and the integral of a hat function at f_j is
+ * h sinc²(ωh/2) cos(ωf_j), with grid step h and ω = πk/2. The sum over j is
+ * the real part of a FFT of 2 * gridSize points, for offset 1 of the grid
+ * values times e^(-jπj/2gridSize). The half hat at 0 is half a hat, since cos
+ * is even around 0. The half hat at 1 also needs a sin term, because cos(ωf)
+ * is only even around 1 for even k.
+ *
+ * @returns false if the FFT could not be allocated
+ */
+static bool cosineMoments(FirFloat moments[], int count, int offset, const FirFloat g[],
+                          int gridSize) {
+    const int fftLength = 2 * gridSize;
+    std::vector<kiss_fft_cpx> out(fftLength);
+    if (offset == 0) {
+        kiss_fftr_cfg cfg = kiss_fftr_alloc(fftLength, 0 /* is_inverse_fft */, NULL, NULL);
+        if (cfg == NULL) {
+            return false;
+        }
+        std::vector<kiss_fft_scalar> in(fftLength, 0.0);
+        std::copy(g, g + gridSize + 1, in.begin());
+        in[0] *= 0.5;
+        in[gridSize] *= 0.5;
+        kiss_fftr(cfg, in.data(), out.data());
+        kiss_fftr_free(cfg);
+    } else {
+        kiss_fft_cfg cfg = kiss_fft_alloc(fftLength, 0 /* is_inverse_fft */, NULL, NULL);
+        if (cfg == NULL) {
+            return false;
+        }
+        std::vector<kiss_fft_cpx> in(fftLength);
+        for (int j = 0; j <= gridSize; j++) {
+            FirFloat value = (j == 0 || j == gridSize) ? 0.5 * g[j] : g[j];
+            FirFloat angle = pi<FirFloat>() * j / fftLength;
+            in[j].r = value * std::cos(angle);
+            in[j].i = -value * std::sin(angle);
+        }
+        for (int j = gridSize + 1; j < fftLength; j++) {
+            in[j].r = 0.0;
+            in[j].i = 0.0;
+        }
+        kiss_fft(cfg, in.data(), out.data());
+        kiss_fft_free(cfg);
+    }
+
+    const FirFloat h = 1.0 / gridSize;
+    for (int n = 0; n < count; n++) {
+        int k = 2 * n + offset;
+        if (k == 0) {
+            moments[n] = h * out[0].r;
+            continue;
+        }
+        FirFloat omega = 0.5 * pi<FirFloat>() * k;
+        FirFloat x = 0.5 * omega * h;
+        FirFloat sinc = std::sin(x) / x;
+        moments[n] = h * sinc * sinc * out[n].r;
+        if (offset == 1) {
+            // sin(ω) is 1 for k = 1, 5, 9, ... and -1 for k = 3, 7, 11, ...
+            FirFloat sinOmega = (k % 4 == 1) ? 1.0 : -1.0;
+            moments[n] += g[gridSize] * sinOmega * (1 - std::sin(omega * h) / (omega * h)) / omega;
+        }
+    }
+    return true;
+}
+
+int firls_sampled(FirFloat result[], int numTaps, int numPoints, const FirFloat frequencies[],
+                  const FirFloat desired[], const FirFloat weight[], FirFloat fs) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    FirFloat nyq = 0.5 * fs;
+    if (nyq <= 0.0) {
+        return FIR_EFREQUENCY;
+    }
+    if (numPoints < 2) {
+        return FIR_ESPEC;
+    }
+    std::vector<FirFloat> points(numPoints);
+    for (int i = 0; i < numPoints; i++) {
+        points[i] = frequencies[i] / nyq;
+        if (points[i] < 0 || points[i] > 1 || (i > 0 && points[i] < points[i - 1])) {
+            return FIR_EBANDS;
+        }
+        if (weight[i] < 0) {
+            return FIR_EWEIGHTS;
+        }
+    }
+    if (points[numPoints - 1] <= points[0]) {
+        return FIR_EBANDS;
+    }
+
+    int gridSize = SAMPLED_GRID_MIN;
+    while (gridSize < SAMPLED_GRID_PER_TAP * numTaps ||
+           gridSize < SAMPLED_GRID_PER_POINT * numPoints) {
+        gridSize *= 2;
+    }
+    std::vector<FirFloat> w(gridSize + 1);
+    std::vector<FirFloat> wd(gridSize + 1);
+    sampleCurve(w.data(), wd.data(), gridSize, numPoints, points.data(), desired, weight);
+
+    int M = (numTaps - 1) / 2;
+    bool isType2 = (numTaps % 2 == 0);
+    std::vector<FirFloat> q(numTaps);
+    std::vector<FirFloat> bValues(M + 1);
+    if (!cosineMoments(q.data(), numTaps, 0, w.data(), gridSize) ||
+        !cosineMoments(bValues.data(), M + 1, isType2 ? 1 : 0, wd.data(), gridSize)) {
+        return FIR_EMEMORY;
+    }
+    VectorMap<FirFloat> b(bValues.data(), M + 1);
+    std::vector<FirFloat> d(numTaps);
+    std::vector<FirFloat> x(numTaps);
+    std::vector<FirFloat> scratch(5 * (size_t)numTaps);
+    solveNormalEquations(result, numTaps, q.data(), b, d.data(), x.data(), scratch.data(),
+                         (FirlsStats *)NULL, false);
     return 0;
 }
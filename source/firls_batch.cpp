@@ -0,0 +1,100 @@
+/*
+ * Design many least squares FIR filters with the same number of taps in
+ * parallel.
+ */
+#include "fir.hpp"
+#include "firls_threads.hpp"
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/*
+ * Emscripten only supports threads when compiled with -pthread, otherwise
+ * std::thread throws at runtime.
+ */
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define FIR_HAVE_THREADS 0
+#else
+#define FIR_HAVE_THREADS 1
+#endif
+
+/*
+ * Design filters until no filters are left. Each worker owns one workspace,
+ * large enough for every spec, so designs do no allocations. With more than
+ * one worker, the designs ignore firls_set_num_threads and run single
+ * threaded: the workers already use the processors.
+ */
+static void designWorker(FirFloat result[], int numFilters, int numTaps, const FirlsSpec specs[],
+                         int status[], size_t workspaceSize, std::atomic<int> *next,
+                         bool singleThreaded) {
+    FirlsSingleThreaded scope(singleThreaded);
+    std::vector<char> workspace(workspaceSize);
+    for (int i = next->fetch_add(1); i < numFilters; i = next->fetch_add(1)) {
+        const FirlsSpec &spec = specs[i];
+        status[i] = firls_ws(result + (size_t)i * (size_t)numTaps, numTaps, spec.numBands,
+                             spec.bands, spec.desiredBegin, spec.desiredEnd, spec.weight, spec.fs,
+                             workspace.data(), workspace.size());
+    }
+}
+
+int firls_batch(FirFloat result[], int numFilters, int numTaps, const FirlsSpec specs[],
+                int status[], int numThreads) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    if (numFilters <= 0) {
+        return 0;
+    }
+
+    int maxBands = 1;
+    for (int i = 0; i < numFilters; i++) {
+        maxBands = std::max(maxBands, specs[i].numBands);
+    }
+    const size_t workspaceSize = firls_workspace_size(numTaps, maxBands);
+
+    std::vector<int> localStatus;
+    if (status == NULL) {
+        localStatus.resize((size_t)numFilters);
+        status = localStatus.data();
+    }
+
+#if FIR_HAVE_THREADS
+    if (numThreads <= 0) {
+        numThreads = (int)std::thread::hardware_concurrency();
+    }
+    numThreads = std::min(numThreads, numFilters);
+#else
+    numThreads = 1;
+#endif
+
+    /*
+     * The calling thread is one of the workers. If the system runs out of
+     * threads, the workers started so far and the calling thread design the
+     * remaining filters.
+     */
+    std::atomic<int> next(0);
+    std::vector<std::thread> threads;
+    threads.reserve((size_t)std::max(numThreads - 1, 0));
+    for (int i = 1; i < numThreads; i++) {
+        try {
+            threads.push_back(std::thread(designWorker, result, numFilters, numTaps, specs,
+                                          status, workspaceSize, &next, true));
+        } catch (const std::system_error &) {
+            break;
+        }
+    }
+    designWorker(result, numFilters, numTaps, specs, status, workspaceSize, &next,
+                 !threads.empty());
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    for (int i = 0; i < numFilters; i++) {
+        if (status[i] != 0) {
+            return status[i];
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef FIRLS_THREADS_HPP
+#define FIRLS_THREADS_HPP
+
+/*
+ * Thread count of the firls designs on the calling thread, shared by firls.cpp
+ * and the workers of firls_batch.cpp. Not part of the public API.
+ */
+
+/*
+ * While an instance with enabled true exists, designs on the calling thread
+ * run on this thread only, whatever firls_set_num_threads set. For threads
+ * that already design in parallel with others, e.g. the firls_batch workers:
+ * an OpenMP team per design would oversubscribe the processors.
+ */
+class FirlsSingleThreaded {
+  public:
+    explicit FirlsSingleThreaded(bool enabled);
+    ~FirlsSingleThreaded();
+    FirlsSingleThreaded(const FirlsSingleThreaded &) = delete;
+    FirlsSingleThreaded &operator=(const FirlsSingleThreaded &) = delete;
+
+  private:
+    bool _previous;
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Conversion of a (linear phase) FIR filter to a minimum phase filter with the
+ * same magnitude response, with the homomorphic (cepstral) method.
+ */
+#include "fir.hpp"
+#include "kiss_fftr.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+/* FFT length per tap if firminphase is called without oversampling */
+static constexpr int MINPHASE_DEFAULT_OVERSAMPLING = 32;
+
+/*
+ * Lower limit of the magnitude relative to the maximum magnitude (-240 dB).
+ * The zeros on the unit circle of a linear phase stop band have no logarithm.
+ */
+static constexpr FirFloat MINPHASE_FLOOR = 1e-12;
+
+int firminphase(FirFloat result[], int numTaps, const FirFloat taps[], int oversampling) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    if (oversampling <= 0) {
+        oversampling = MINPHASE_DEFAULT_OVERSAMPLING;
+    }
+    int n = 64;
+    while (n < oversampling * numTaps) {
+        n *= 2;
+    }
+    const int numBins = n / 2 + 1;
+    kiss_fftr_cfg forward = kiss_fftr_alloc(n, 0 /* is_inverse_fft */, NULL, NULL);
+    kiss_fftr_cfg inverse = kiss_fftr_alloc(n, 1 /* is_inverse_fft */, NULL, NULL);
+    if (forward == NULL || inverse == NULL) {
+        kiss_fftr_free(forward);
+        kiss_fftr_free(inverse);
+        return FIR_EMEMORY;
+    }
+    std::vector<kiss_fft_scalar> time(n, 0.0);
+    std::vector<kiss_fft_cpx> spectrum(numBins);
+
+    // log magnitude of the filter
+    std::copy(taps, taps + numTaps, time.begin());
+    kiss_fftr(forward, time.data(), spectrum.data());
+    FirFloat maxMagnitude = 0.0;
+    for (int k = 0; k < numBins; k++) {
+        spectrum[k].r = std::hypot(spectrum[k].r, spectrum[k].i);
+        spectrum[k].i = 0.0;
+        maxMagnitude = std::max(maxMagnitude, spectrum[k].r);
+    }
+    if (maxMagnitude == 0.0) {
+        std::fill(result, result + numTaps, 0.0);
+        kiss_fftr_free(forward);
+        kiss_fftr_free(inverse);
+        return 0;
+    }
+    const FirFloat minMagnitude = MINPHASE_FLOOR * maxMagnitude;
+    for (int k = 0; k < numBins; k++) {
+        spectrum[k].r = std::log(std::max(spectrum[k].r, minMagnitude));
+    }
+
+    // real cepstrum, folded to the causal part: c[0], 2c[k] for 0 < k < n/2, c[n/2]
+    kiss_fftri(inverse, spectrum.data(), time.data());
+    for (int i = 0; i < n; i++) {
+        time[i] /= n;
+    }
+    for (int i = 1; i < n / 2; i++) {
+        time[i] *= 2;
+    }
+    std::fill(time.begin() + n / 2 + 1, time.end(), 0.0);
+
+    // the minimum phase spectrum is the exponential of the FFT of the folded cepstrum
+    kiss_fftr(forward, time.data(), spectrum.data());
+    for (int k = 0; k < numBins; k++) {
+        std::complex<FirFloat> value =
+            std::exp(std::complex<FirFloat>(spectrum[k].r, spectrum[k].i));
+        spectrum[k].r = value.real();
+        spectrum[k].i = value.imag();
+    }
+    kiss_fftri(inverse, spectrum.data(), time.data());
+    for (int i = 0; i < numTaps; i++) {
+        result[i] = time[i] / n;
+    }
+    kiss_fftr_free(forward);
+    kiss_fftr_free(inverse);
+    return 0;
+}
@@ -0,0 +1,324 @@
+#include "fir.hpp"
+#include "fir_bands.hpp"
+#include <cmath>
+#include <vector>
+
+/*
+ * Parks-McClellan (Remez exchange) design of type I and type II linear phase
+ * filters, following J. H. McClellan, T. W. Parks, L. R. Rabiner, "A computer
+ * program for designing optimum FIR linear phase digital filters" (1973), and
+ * the C translation by Jake Janovetz used by SciPy signal.remez.
+ *
+ * The amplitude response of a filter with r cosine terms is a polynomial of
+ * degree r - 1 in x = cos(πf), f relative to nyquist. Every iteration
+ * interpolates the polynomial with the alternating error ±δ on r + 1 trial
+ * extremal frequencies, evaluates the weighted error on a dense grid with the
+ * barycentric Lagrange formula in O(r) per point, and moves the extremal
+ * frequencies to the extrema of this error.
+ *
+ * For type II (even numTaps) the amplitude is cos(πf/2) P(x): P is designed
+ * for the desired response D / cos(πf/2) and the weight W cos(πf/2).
+ */
+
+/* Grid points per cosine term, as in SciPy */
+static constexpr int GRID_DENSITY = 16;
+static constexpr int MAX_ITERATIONS = 40;
+/* Converged when the extremal errors differ less than this, relative */
+static constexpr FirFloat CONVERGENCE = 1e-4;
+
+static constexpr FirFloat PI = 3.14159265358979323846;
+
+/* Dense grid of the bands: x = cos(πf), desired and weight of P */
+struct RemezGrid {
+    std::vector<FirFloat> x;
+    std::vector<FirFloat> desired;
+    std::vector<FirFloat> weight;
+};
+
+/*
+ * Check the bands and the weights, and build the grid.
+ *
+ * @returns 0 on success, error code on failure
+ */
+static int buildGrid(RemezGrid &grid, int numTaps, int r, int numBands, const FirFloat bands[],
+                     const FirFloat desiredBegin[], const FirFloat desiredEnd[],
+                     const FirFloat weight[], FirFloat nyq) {
+    std::vector<FirFloat> edges(2 * numBands);
+    int error = firScaleBands(edges.data(), numBands, bands, weight, nyq);
+    if (error != 0) {
+        return error;
+    }
+    FirFloat totalWidth = 0.0;
+    for (int i = 0; i < numBands; i++) {
+        // the alternating error ±δ/W requires nonzero weights
+        if (!(weight[i] > 0)) {
+            return FIR_EWEIGHTS;
+        }
+        totalWidth += edges[2 * i + 1] - edges[2 * i];
+    }
+
+    // approx GRID_DENSITY * r points over all bands together
+    const bool isType2 = (numTaps % 2 == 0);
+    const FirFloat step = totalWidth / (GRID_DENSITY * r);
+    for (int i = 0; i < numBands; i++) {
+        const FirFloat begin = edges[2 * i];
+        const FirFloat end = edges[2 * i + 1];
+        const int numPoints = (int)std::lround((end - begin) / step) + 1;
+        for (int k = 0; k < numPoints; k++) {
+            FirFloat f = (k == numPoints - 1) ? end : begin + k * step;
+            if (isType2 && f > 1 - step) {
+                // type II has a zero at nyquist
+                f = 1 - step;
+            }
+            if (!grid.x.empty() && std::cos(PI * f) >= grid.x.back()) {
+                // shared edge of contiguous bands, or clipped at nyquist
+                continue;
+            }
+            FirFloat desired =
+                desiredBegin[i] + (desiredEnd[i] - desiredBegin[i]) * (f - begin) / (end - begin);
+            FirFloat w = weight[i];
+            if (isType2) {
+                FirFloat c = std::cos(0.5 * PI * f);
+                desired /= c;
+                w *= c;
+            }
+            grid.x.push_back(std::cos(PI * f));
+            grid.desired.push_back(desired);
+            grid.weight.push_back(w);
+        }
+    }
+    return ((int)grid.x.size() < r + 1) ? FIR_EBANDS : 0;
+}
+
+/*
+ * Barycentric weights 1 / Π(2 (x[k] - x[j])), j != k. The factor 2 and
+ * multiplying in interleaved order keep the products in range for many
+ * points.
+ */
+static void barycentricWeights(FirFloat weights[], const FirFloat x[], int n) {
+    const int stride = (n - 1) / 15 + 1;
+    for (int k = 0; k < n; k++) {
+        FirFloat denominator = 1.0;
+        for (int l = 0; l < stride; l++) {
+            for (int j = l; j < n; j += stride) {
+                if (j != k) {
+                    denominator *= 2 * (x[k] - x[j]);
+                }
+            }
+        }
+        weights[k] = 1 / denominator;
+    }
+}
+
+/* Barycentric Lagrange interpolation of the n points (x[i], y[i]) at xi */
+static FirFloat interpolate(FirFloat xi, const FirFloat x[], const FirFloat y[],
+                            const FirFloat weights[], int n) {
+    FirFloat numerator = 0.0;
+    FirFloat denominator = 0.0;
+    for (int i = 0; i < n; i++) {
+        FirFloat diff = xi - x[i];
+        if (diff == 0.0) {
+            return y[i];
+        }
+        FirFloat c = weights[i] / diff;
+        numerator += c * y[i];
+        denominator += c;
+    }
+    return numerator / denominator;
+}
+
+/*
+ * P(x) of the filter h with Clenshaw's recurrence: the amplitude is a sum of
+ * Chebyshev polynomials T_k(x) = cos(kω) for type I, and for type II
+ * cos(ω/2) times a sum of V_k(x) = cos((k + 1/2)ω) / cos(ω/2), third kind.
+ */
+static FirFloat evaluateFilter(FirFloat x, const FirFloat h[], int numTaps, int r) {
+    const int M = (numTaps - 1) / 2;
+    const bool isType2 = (numTaps % 2 == 0);
+    FirFloat b1 = 0.0;
+    FirFloat b2 = 0.0;
+    for (int k = r - 1; k >= 1; k--) {
+        FirFloat b0 = 2 * h[M - k] + 2 * x * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    if (isType2) {
+        // V_0 = 1, V_1 = 2x - 1
+        return 2 * h[M] + 2 * x * b1 - b2 - b1;
+    }
+    // T_0 = 1, T_1 = x, the middle tap is not doubled
+    return h[M] + x * b1 - b2;
+}
+
+/*
+ * Polynomial P of degree r - 1 for the r + 1 extremal frequencies: the
+ * interpolation points x, values y and barycentric weights of P.
+ *
+ * @returns the deviation δ
+ */
+static FirFloat solveInterpolant(std::vector<FirFloat> &x, std::vector<FirFloat> &y,
+                                 std::vector<FirFloat> &weights, const RemezGrid &grid,
+                                 const std::vector<int> &extremal, int r) {
+    for (int i = 0; i <= r; i++) {
+        x[i] = grid.x[extremal[i]];
+    }
+    barycentricWeights(weights.data(), x.data(), r + 1);
+
+    // δ such that P - D alternates ±δ/W on the r + 1 extremal frequencies
+    FirFloat numerator = 0.0;
+    FirFloat denominator = 0.0;
+    FirFloat sign = 1.0;
+    for (int i = 0; i <= r; i++) {
+        numerator += weights[i] * grid.desired[extremal[i]];
+        denominator += sign * weights[i] / grid.weight[extremal[i]];
+        sign = -sign;
+    }
+    const FirFloat delta = numerator / denominator;
+
+    // P through the first r of them; the weights for r points are those for
+    // r + 1 points times (x[i] - x[r])
+    sign = 1.0;
+    for (int i = 0; i < r; i++) {
+        y[i] = grid.desired[extremal[i]] - sign * delta / grid.weight[extremal[i]];
+        weights[i] *= x[i] - x[r];
+        sign = -sign;
+    }
+    return delta;
+}
+
+/*
+ * Find r + 1 alternating extrema of the error on the grid.
+ *
+ * @returns false if there are less than r + 1
+ */
+static bool searchExtrema(std::vector<int> &extremal, const std::vector<FirFloat> &error, int r) {
+    const int last = (int)error.size() - 1;
+    std::vector<int> found;
+    for (int k = 0; k <= last; k++) {
+        const FirFloat e = error[k];
+        bool isMaximum = e > 0 && (k == 0 || e >= error[k - 1]) && (k == last || e > error[k + 1]);
+        bool isMinimum = e < 0 && (k == 0 || e <= error[k - 1]) && (k == last || e < error[k + 1]);
+        if (!isMaximum && !isMinimum) {
+            continue;
+        }
+        // of consecutive extrema with the same sign, keep the largest
+        if (!found.empty() && (error[found.back()] > 0) == (e > 0)) {
+            if (std::fabs(e) > std::fabs(error[found.back()])) {
+                found.back() = k;
+            }
+        } else {
+            found.push_back(k);
+        }
+    }
+    if ((int)found.size() < r + 1) {
+        return false;
+    }
+    // remove the smallest of the outer extrema, this keeps the alternation
+    size_t first = 0;
+    size_t end = found.size();
+    while ((int)(end - first) > r + 1) {
+        if (std::fabs(error[found[first]]) < std::fabs(error[found[end - 1]])) {
+            first++;
+        } else {
+            end--;
+        }
+    }
+    extremal.assign(found.begin() + (long)first, found.begin() + (long)end);
+    return true;
+}
+
+int firremez(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+             const FirFloat desiredBegin[], const FirFloat desiredEnd[], const FirFloat weight[],
+             FirFloat fs) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    FirFloat nyq = 0.5 * fs;
+    if (nyq <= 0.0) {
+        return FIR_EFREQUENCY;
+    }
+    if (numBands <= 0) {
+        return FIR_ENUMBANDS;
+    }
+    const bool isType2 = (numTaps % 2 == 0);
+    const int r = isType2 ? numTaps / 2 : (numTaps + 1) / 2;
+
+    RemezGrid grid;
+    int error = buildGrid(grid, numTaps, r, numBands, bands, desiredBegin, desiredEnd, weight, nyq);
+    if (error != 0) {
+        return error;
+    }
+    const int gridSize = (int)grid.x.size();
+
+    // Initial extremal frequencies: the extrema of the error of the least
+    // squares design. They are close to the optimal ones, so the iterations
+    // start with a realistic δ; from equally spaced frequencies, δ is far
+    // below the optimum and drowns in the rounding errors for small ripples.
+    error = firls(result, numTaps, numBands, bands, desiredBegin, desiredEnd, weight, fs);
+    if (error != 0) {
+        return error;
+    }
+    std::vector<FirFloat> gridError(gridSize);
+    for (int k = 0; k < gridSize; k++) {
+        FirFloat p = evaluateFilter(grid.x[k], result, numTaps, r);
+        gridError[k] = grid.weight[k] * (grid.desired[k] - p);
+    }
+    std::vector<int> extremal;
+    if (!searchExtrema(extremal, gridError, r)) {
+        extremal.resize(r + 1);
+        for (int i = 0; i <= r; i++) {
+            extremal[i] = (int)((long long)i * (gridSize - 1) / r);
+        }
+    }
+
+    std::vector<FirFloat> x(r + 1);
+    std::vector<FirFloat> y(r);
+    std::vector<FirFloat> weights(r + 1);
+    bool converged = false;
+    for (int iteration = 0; iteration < MAX_ITERATIONS && !converged; iteration++) {
+        FirFloat delta = solveInterpolant(x, y, weights, grid, extremal, r);
+        for (int k = 0; k < gridSize; k++) {
+            FirFloat p = interpolate(grid.x[k], x.data(), y.data(), weights.data(), r);
+            gridError[k] = grid.weight[k] * (grid.desired[k] - p);
+        }
+
+        std::vector<int> next;
+        if (!std::isfinite(delta) || !searchExtrema(next, gridError, r)) {
+            // numerical breakdown, typically for a ripple below approx 1e-8
+            break;
+        }
+        FirFloat minError = std::fabs(gridError[next[0]]);
+        FirFloat maxError = minError;
+        for (int k : next) {
+            minError = std::fmin(minError, std::fabs(gridError[k]));
+            maxError = std::fmax(maxError, std::fabs(gridError[k]));
+        }
+        converged = (maxError - minError) <= CONVERGENCE * maxError;
+        extremal.swap(next);
+    }
+    if (!converged) {
+        // keep the least squares design
+        return FIR_ECONVERGENCE;
+    }
+
+    // Taps from the amplitude response sampled at f = 2k / numTaps (frequency
+    // sampling), the type II amplitude is zero at nyquist
+    const int M = (numTaps - 1) / 2;
+    std::vector<FirFloat> amplitude(M + 1);
+    for (int k = 0; k <= M; k++) {
+        FirFloat f = 2.0 * k / numTaps;
+        amplitude[k] = interpolate(std::cos(PI * f), x.data(), y.data(), weights.data(), r);
+        if (isType2) {
+            amplitude[k] *= std::cos(0.5 * PI * f);
+        }
+    }
+    const FirFloat center = 0.5 * (numTaps - 1);
+    for (int n = 0; n <= M; n++) {
+        FirFloat sum = amplitude[0];
+        for (int k = 1; k <= M; k++) {
+            sum += 2 * amplitude[k] * std::cos(2 * PI * k * (n - center) / numTaps);
+        }
+        result[n] = result[numTaps - 1 - n] = sum / numTaps;
+    }
+    return 0;
+}
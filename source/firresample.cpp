@@ -0,0 +1,135 @@
+/*
+ * Polyphase FIR resampling by a rational factor L / M: upsampling by L,
+ * filtering and downsampling by M, calculating only the retained outputs.
+ * Templated on the sample type, for the double (FirResampler) and float
+ * (FirResamplerF) entry points.
+ */
+#include "fir.hpp"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <vector>
+
+/* Number of input samples per pass, the history and the new samples stay in cache */
+static constexpr int RESAMPLE_BLOCK = 1024;
+
+template <typename T> using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+template <typename T> using ConstVectorMap = Eigen::Map<const Vector<T>>;
+
+/*
+ * The taps are split in L phases of phaseLength taps, phase p holds the taps
+ * h[p], h[p + L], h[p + 2L], ... in reverse order, so output samples are dot
+ * products of a phase with a contiguous segment of the input. All phases are
+ * stored contiguously, phase p starts at phases[p * phaseLength].
+ *
+ * The history holds the last phaseLength - 1 input samples, followed by room
+ * for a block of new samples. `newest` is the index in the history of the
+ * newest input sample for the next output, `phase` its phase.
+ */
+template <typename T> struct ResamplerState {
+    int interpolation;
+    int decimation;
+    int phaseLength;
+    std::vector<T> phases;
+    std::vector<T> history;
+    int newest;
+    int phase;
+};
+
+struct FirResampler : ResamplerState<FirFloat> {};
+struct FirResamplerF : ResamplerState<float> {};
+
+template <typename T> static void resetResampler(ResamplerState<T> *resampler) {
+    if (resampler != NULL) {
+        std::fill(resampler->history.begin(), resampler->history.end(), (T)0);
+        resampler->newest = resampler->phaseLength - 1;
+        resampler->phase = 0;
+    }
+}
+
+template <typename Resampler, typename T>
+static Resampler *createResampler(int interpolation, int decimation, int numTaps,
+                                  const T taps[]) {
+    if (interpolation < 1 || decimation < 1 || numTaps < 1 || taps == NULL) {
+        return NULL;
+    }
+    Resampler *resampler = new Resampler;
+    resampler->interpolation = interpolation;
+    resampler->decimation = decimation;
+    const int phaseLength = (numTaps + interpolation - 1) / interpolation;
+    resampler->phaseLength = phaseLength;
+    resampler->phases.assign((size_t)interpolation * (size_t)phaseLength, (T)0);
+    for (int p = 0; p < interpolation; p++) {
+        T *phase = &resampler->phases[(size_t)p * (size_t)phaseLength];
+        for (int k = 0; k < phaseLength; k++) {
+            const int tap = p + k * interpolation;
+            phase[phaseLength - 1 - k] = (tap < numTaps) ? taps[tap] : (T)0;
+        }
+    }
+    resampler->history.resize((size_t)(phaseLength - 1 + RESAMPLE_BLOCK));
+    resetResampler<T>(resampler);
+    return resampler;
+}
+
+template <typename T>
+static int processResampler(ResamplerState<T> *resampler, const T input[], int n, T output[]) {
+    if (resampler == NULL || n < 0) {
+        return -1;
+    }
+    const int L = resampler->interpolation;
+    const int M = resampler->decimation;
+    const int phaseLength = resampler->phaseLength;
+    T *history = resampler->history.data();
+    const T *phases = resampler->phases.data();
+    int numOutput = 0;
+
+    for (int start = 0; start < n; start += RESAMPLE_BLOCK) {
+        const int blockSize = std::min(RESAMPLE_BLOCK, n - start);
+        std::copy(input + start, input + start + blockSize, history + phaseLength - 1);
+        const int end = phaseLength - 1 + blockSize;
+
+        int newest = resampler->newest;
+        int phase = resampler->phase;
+        while (newest < end) {
+            ConstVectorMap<T> taps(phases + (size_t)phase * (size_t)phaseLength, phaseLength);
+            ConstVectorMap<T> x(history + newest - (phaseLength - 1), phaseLength);
+            output[numOutput++] = taps.dot(x);
+            phase += M;
+            newest += phase / L;
+            phase %= L;
+        }
+
+        /* keep the last phaseLength - 1 samples for the next block */
+        std::copy(history + blockSize, history + blockSize + phaseLength - 1, history);
+        resampler->newest = newest - blockSize;
+        resampler->phase = phase;
+    }
+    return numOutput;
+}
+
+FirResampler *firresampler_create(int interpolation, int decimation, int numTaps,
+                                  const FirFloat taps[]) {
+    return createResampler<FirResampler>(interpolation, decimation, numTaps, taps);
+}
+
+int firresampler_process(FirResampler *resampler, const FirFloat input[], int n,
+                         FirFloat output[]) {
+    return processResampler<FirFloat>(resampler, input, n, output);
+}
+
+void firresampler_reset(FirResampler *resampler) { resetResampler<FirFloat>(resampler); }
+
+void firresampler_destroy(FirResampler *resampler) { delete resampler; }
+
+FirResamplerF *firresampler_create_f(int interpolation, int decimation, int numTaps,
+                                     const float taps[]) {
+    return createResampler<FirResamplerF>(interpolation, decimation, numTaps, taps);
+}
+
+int firresampler_process_f(FirResamplerF *resampler, const float input[], int n,
+                           float output[]) {
+    return processResampler<float>(resampler, input, n, output);
+}
+
+void firresampler_reset_f(FirResamplerF *resampler) { resetResampler<float>(resampler); }
+
+void firresampler_destroy_f(FirResamplerF *resampler) { delete resampler; }
@@ -0,0 +1,157 @@
+#include "fir.hpp"
+#include "fir_bands.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/*
+ * Window method (windowed sinc) design of linear phase filters, as SciPy
+ * signal.firwin. The ideal response is piecewise constant, with the steps
+ * halfway the transition bands. Its impulse response is a sum of sinc
+ * functions, truncated to numTaps and multiplied with a window: O(numTaps)
+ * per band, without any system of equations.
+ *
+ * Kaiser's design rules (J. F. Kaiser, "Nonrecursive digital filter design
+ * using the I0-sinh window function", 1974) relate the stop band attenuation
+ * to the window parameter beta.
+ */
+
+static constexpr FirFloat PI = 3.14159265358979323846;
+
+/* Zeroth order modified Bessel function of the first kind, power series */
+static FirFloat besselI0(FirFloat x) {
+    const FirFloat q = 0.25 * x * x;
+    FirFloat term = 1.0;
+    FirFloat sum = 1.0;
+    for (int k = 1; term > 1e-17 * sum; k++) {
+        term *= q / ((FirFloat)k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+/* Kaiser window parameter beta for a stop band attenuation in dB */
+static FirFloat kaiserBeta(FirFloat attenuation) {
+    if (attenuation > 50) {
+        return 0.1102 * (attenuation - 8.7);
+    }
+    if (attenuation > 21) {
+        return 0.5842 * std::pow(attenuation - 21, 0.4) + 0.07886 * (attenuation - 21);
+    }
+    return 0.0;
+}
+
+/* sin(πx)/πx */
+static FirFloat sinc(FirFloat x) { return (x == 0.0) ? 1.0 : std::sin(PI * x) / (PI * x); }
+
+/*
+ * Symmetric window of numTaps values.
+ *
+ * @returns 0 on success, FIR_EWINDOW for an unknown window or invalid attenuation
+ */
+static int makeWindow(std::vector<FirFloat> &window, int numTaps, int type,
+                      FirFloat attenuation) {
+    window.assign(numTaps, 1.0);
+    FirFloat beta = 0.0;
+    if (type == FIR_WINDOW_KAISER) {
+        if (!(attenuation >= 0) || !std::isfinite(attenuation)) {
+            return FIR_EWINDOW;
+        }
+        beta = kaiserBeta(attenuation);
+    } else if (type != FIR_WINDOW_HANN && type != FIR_WINDOW_BLACKMAN) {
+        return FIR_EWINDOW;
+    }
+    if (numTaps == 1) {
+        return 0;
+    }
+    // exactly symmetric: calculate the first half, and mirror it
+    const FirFloat i0Beta = besselI0(beta);
+    for (int n = 0; n <= (numTaps - 1) / 2; n++) {
+        // r from -1 to 1
+        FirFloat r = 2.0 * n / (numTaps - 1) - 1.0;
+        switch (type) {
+        case FIR_WINDOW_HANN:
+            window[n] = 0.5 + 0.5 * std::cos(PI * r);
+            break;
+        case FIR_WINDOW_BLACKMAN:
+            window[n] = 0.42 + 0.5 * std::cos(PI * r) + 0.08 * std::cos(2 * PI * r);
+            break;
+        default:
+            window[n] = besselI0(beta * std::sqrt(std::max(1.0 - r * r, 0.0))) / i0Beta;
+            break;
+        }
+        window[numTaps - 1 - n] = window[n];
+    }
+    return 0;
+}
+
+int firwin(FirFloat result[], int numTaps, int numBands, const FirFloat bands[],
+           const FirFloat desired[], int window, FirFloat attenuation, FirFloat fs) {
+    if (numTaps < 1) {
+        return FIR_ENUMTAPS;
+    }
+    FirFloat nyq = 0.5 * fs;
+    if (nyq <= 0.0) {
+        return FIR_EFREQUENCY;
+    }
+    if (numBands <= 0) {
+        return FIR_ENUMBANDS;
+    }
+    std::vector<FirFloat> edges(2 * numBands);
+    int error = firScaleBands(edges.data(), numBands, bands, (const FirFloat *)NULL, nyq);
+    if (error != 0) {
+        return error;
+    }
+    std::vector<FirFloat> w;
+    error = makeWindow(w, numTaps, window, attenuation);
+    if (error != 0) {
+        return error;
+    }
+
+    // steps of the ideal response, relative to nyquist: band j is from
+    // cutoff[j] to cutoff[j + 1]
+    std::vector<FirFloat> cutoff(numBands + 1);
+    cutoff[0] = 0.0;
+    cutoff[numBands] = 1.0;
+    for (int j = 1; j < numBands; j++) {
+        cutoff[j] = 0.5 * (edges[2 * j - 1] + edges[2 * j]);
+    }
+
+    // An ideal low pass with cutoff c has the impulse response c sinc(ct).
+    // Band j is the difference of the low passes at cutoff[j + 1] and
+    // cutoff[j], so each step contributes once, with the change of the gain.
+    // The filter is symmetric: calculate the first half, and mirror it.
+    const FirFloat middle = 0.5 * (numTaps - 1);
+    for (int n = 0; n <= (numTaps - 1) / 2; n++) {
+        FirFloat t = n - middle;
+        FirFloat h = desired[numBands - 1] * sinc(t);
+        for (int j = 1; j < numBands; j++) {
+            h += (desired[j - 1] - desired[j]) * cutoff[j] * sinc(cutoff[j] * t);
+        }
+        result[n] = result[numTaps - 1 - n] = h * w[n];
+    }
+
+    // As SciPy: scale to the exact desired gain in the center of the first
+    // band with a non-zero gain, or at 0 Hz or nyquist if that band includes
+    // them. The window changes the gain of the pass band somewhat.
+    for (int j = 0; j < numBands; j++) {
+        if (desired[j] == 0.0) {
+            continue;
+        }
+        FirFloat center = (j == 0) ? 0.0
+                          : (j == numBands - 1) ? 1.0
+                                                : 0.5 * (cutoff[j] + cutoff[j + 1]);
+        FirFloat gain = 0.0;
+        for (int n = 0; n < numTaps; n++) {
+            gain += result[n] * std::cos(PI * center * (n - middle));
+        }
+        // type II filters have a zero at nyquist
+        if (std::fabs(gain) > 1e-6 * std::fabs(desired[j])) {
+            for (int n = 0; n < numTaps; n++) {
+                result[n] *= desired[j] / gain;
+            }
+        }
+        break;
+    }
+    return 0;
+}
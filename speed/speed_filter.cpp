@@ -0,0 +1,122 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+/* time in us to filter numSamples samples in blocks of blockSize */
+static int timeFilter(FirFilter *filter, const std::vector<FirFloat> &x, std::vector<FirFloat> &y,
+                      int numSamples, int blockSize) {
+    Stopwatch s;
+    for (int start = 0; start + blockSize <= numSamples; start += blockSize) {
+        firfilter_process(filter, &x[start], &y[start], blockSize);
+    }
+    int elapsed = s.elapsed();
+    return elapsed > 0 ? elapsed : 1;
+}
+
+/* same for the single precision filter */
+static int timeFilterF(FirFilterF *filter, const std::vector<float> &x, std::vector<float> &y,
+                       int numSamples, int blockSize) {
+    Stopwatch s;
+    for (int start = 0; start + blockSize <= numSamples; start += blockSize) {
+        firfilter_process_f(filter, &x[start], &y[start], blockSize);
+    }
+    int elapsed = s.elapsed();
+    return elapsed > 0 ? elapsed : 1;
+}
+
+/*
+ * Throughput of the streaming direct form filter, for symmetric taps (as
+ * designed by firls) and the same taps made asymmetric. Next, the crossover
+ * between direct form and overlap-save FFT convolution, for some block sizes
+ * (= latency of FFT convolution), and the method selected automatically.
+ * Last, double and float filters with the same taps for all methods.
+ */
+int main() {
+    const int NUMSAMPLES = 1 << 18;
+    const int BLOCKSIZE = 512;
+    const int NUMTAPS[] = {15, 31, 63, 127, 255, 511, 1023, 2047};
+
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.1, 0.15, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+
+    std::vector<FirFloat> x(NUMSAMPLES);
+    for (int i = 0; i < NUMSAMPLES; i++) {
+        x[i] = std::sin(0.01 * i);
+    }
+    std::vector<FirFloat> y(NUMSAMPLES);
+
+    for (int numTaps : NUMTAPS) {
+        std::vector<FirFloat> h(numTaps);
+        firls(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0);
+        for (int symmetric = 1; symmetric >= 0; symmetric--) {
+            if (!symmetric) {
+                h[0] *= 1.0 + 1e-9;
+            }
+            FirFilter *filter = firfilter_create(numTaps, h.data());
+            int elapsed = timeFilter(filter, x, y, NUMSAMPLES, BLOCKSIZE);
+            firfilter_destroy(filter);
+            printf("filter %4d taps %s: %8d us, %7.2f Msamples/s\n", numTaps,
+                   symmetric ? "symmetric " : "asymmetric", elapsed,
+                   (double)NUMSAMPLES / elapsed);
+        }
+    }
+
+    const int CROSSOVER_BLOCKSIZES[] = {64, 256, 1024};
+    printf("\nMsamples/s, symmetric taps\n");
+    printf("block  taps    direct       fft  auto\n");
+    for (int blockSize : CROSSOVER_BLOCKSIZES) {
+        for (int numTaps = 8; numTaps <= 16384; numTaps *= 2) {
+            // symmetric taps, the values do not matter for the speed
+            std::vector<FirFloat> h(numTaps + 1);
+            for (int i = 0; i <= numTaps; i++) {
+                h[i] = 1.0 / (1 + std::abs(i - numTaps / 2));
+            }
+            // limit the duration of the slow direct form for long filters
+            const int numSamples =
+                std::min(NUMSAMPLES, std::max((1 << 26) / numTaps, 4 * blockSize));
+
+            FirFilter *direct =
+                firfilter_create_method(numTaps + 1, h.data(), FIR_FILTER_DIRECT, 0);
+            FirFilter *fft =
+                firfilter_create_method(numTaps + 1, h.data(), FIR_FILTER_FFT, blockSize);
+            FirFilter *automatic =
+                firfilter_create_method(numTaps + 1, h.data(), FIR_FILTER_AUTO, blockSize);
+            int elapsedDirect = timeFilter(direct, x, y, numSamples, blockSize);
+            int elapsedFft = timeFilter(fft, x, y, numSamples, blockSize);
+            printf("%5d %5d %9.2f %9.2f  %s\n", blockSize, numTaps + 1,
+                   (double)numSamples / elapsedDirect, (double)numSamples / elapsedFft,
+                   firfilter_method(automatic) == FIR_FILTER_FFT ? "fft" : "direct");
+            firfilter_destroy(direct);
+            firfilter_destroy(fft);
+            firfilter_destroy(automatic);
+        }
+    }
+
+    const int PRECISION_NUMTAPS[] = {63, 511, 4095};
+    const char *METHOD_NAMES[] = {"", "direct", "fft", "partitioned"};
+    std::vector<float> x_f(x.begin(), x.end());
+    std::vector<float> y_f(NUMSAMPLES);
+    printf("\nMsamples/s, block size %d\n", BLOCKSIZE);
+    printf(" taps  method         double     float\n");
+    for (int numTaps : PRECISION_NUMTAPS) {
+        std::vector<FirFloat> h(numTaps);
+        firls(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0);
+        std::vector<float> h_f(h.begin(), h.end());
+        for (int method : {FIR_FILTER_DIRECT, FIR_FILTER_FFT, FIR_FILTER_PARTITIONED}) {
+            const int numSamples = std::min(NUMSAMPLES, std::max((1 << 26) / numTaps, BLOCKSIZE));
+            FirFilter *filter = firfilter_create_method(numTaps, h.data(), method, BLOCKSIZE);
+            FirFilterF *filter_f = firfilter_create_method_f(numTaps, h_f.data(), method, BLOCKSIZE);
+            int elapsed = timeFilter(filter, x, y, numSamples, BLOCKSIZE);
+            int elapsed_f = timeFilterF(filter_f, x_f, y_f, numSamples, BLOCKSIZE);
+            printf("%5d  %-11s %9.2f %9.2f\n", numTaps, METHOD_NAMES[method],
+                   (double)numSamples / elapsed, (double)numSamples / elapsed_f);
+            firfilter_destroy(filter);
+            firfilter_destroy_f(filter_f);
+        }
+    }
+}
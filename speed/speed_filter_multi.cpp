@@ -0,0 +1,104 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+/* number of runs per measurement, the fastest one is reported */
+static const int REPEATS = 5;
+
+/* one mono filter per channel, on interleaved samples */
+static void processMono(std::vector<FirFilter *> &mono, const FirFloat x[], FirFloat y[],
+                        int numFrames, int blockSize) {
+    const int numChannels = (int)mono.size();
+    std::vector<FirFloat> channelIn(blockSize);
+    std::vector<FirFloat> channelOut(blockSize);
+    for (int start = 0; start + blockSize <= numFrames; start += blockSize) {
+        const FirFloat *in = x + (size_t)start * numChannels;
+        FirFloat *out = y + (size_t)start * numChannels;
+        for (int c = 0; c < numChannels; c++) {
+            for (int i = 0; i < blockSize; i++) {
+                channelIn[i] = in[i * numChannels + c];
+            }
+            firfilter_process(mono[c], channelIn.data(), channelOut.data(), blockSize);
+            for (int i = 0; i < blockSize; i++) {
+                out[i * numChannels + c] = channelOut[i];
+            }
+        }
+    }
+}
+
+static void processMulti(FirFilterMulti *filter, int numChannels, const FirFloat x[],
+                         FirFloat y[], int numFrames, int blockSize) {
+    for (int start = 0; start + blockSize <= numFrames; start += blockSize) {
+        firfilter_multi_process(filter, x + (size_t)start * numChannels,
+                                y + (size_t)start * numChannels, blockSize);
+    }
+}
+
+/*
+ * Throughput of filtering many channels with the same taps: one mono filter
+ * per channel (including the conversion from and to interleaved samples)
+ * against the multichannel filter with interleaved and planar samples.
+ */
+int main() {
+    const int NUMVALUES = 1 << 17;
+    const int BLOCKSIZE = 512;
+    const int NUMCHANNELS[] = {2, 8, 64};
+    const int NUMTAPS[] = {31, 127, 511};
+
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.1, 0.15, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+
+    std::vector<FirFloat> x(NUMVALUES);
+    for (int i = 0; i < NUMVALUES; i++) {
+        x[i] = std::sin(0.01 * i);
+    }
+    std::vector<FirFloat> y(NUMVALUES);
+
+    printf("Msamples/s (all channels), symmetric taps\n");
+    printf("channels  taps  per channel  interleaved   planar\n");
+    for (int numChannels : NUMCHANNELS) {
+        const int numFrames = std::max(NUMVALUES / numChannels / BLOCKSIZE, 1) * BLOCKSIZE;
+        const int numValues = numFrames * numChannels;
+        x.resize(numValues);
+        y.resize(numValues);
+        for (int numTaps : NUMTAPS) {
+            std::vector<FirFloat> h(numTaps);
+            firls(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0);
+
+            std::vector<FirFilter *> mono(numChannels);
+            for (int c = 0; c < numChannels; c++) {
+                mono[c] = firfilter_create(numTaps, h.data());
+            }
+            FirFilterMulti *interleaved =
+                firfilter_multi_create(numChannels, numTaps, h.data(), FIR_LAYOUT_INTERLEAVED);
+            FirFilterMulti *planar =
+                firfilter_multi_create(numChannels, numTaps, h.data(), FIR_LAYOUT_PLANAR);
+            int elapsed[3] = {1 << 30, 1 << 30, 1 << 30};
+            for (int r = 0; r < REPEATS; r++) {
+                Stopwatch s;
+                processMono(mono, x.data(), y.data(), numFrames, BLOCKSIZE);
+                elapsed[0] = std::min(elapsed[0], s.elapsed());
+                Stopwatch s2;
+                processMulti(interleaved, numChannels, x.data(), y.data(), numFrames, BLOCKSIZE);
+                elapsed[1] = std::min(elapsed[1], s2.elapsed());
+                Stopwatch s3;
+                processMulti(planar, numChannels, x.data(), y.data(), numFrames, BLOCKSIZE);
+                elapsed[2] = std::min(elapsed[2], s3.elapsed());
+            }
+            for (FirFilter *filter : mono) {
+                firfilter_destroy(filter);
+            }
+            firfilter_multi_destroy(interleaved);
+            firfilter_multi_destroy(planar);
+            printf("%8d %5d %12.2f %12.2f %8.2f\n", numChannels, numTaps,
+                   (double)numValues / std::max(elapsed[0], 1),
+                   (double)numValues / std::max(elapsed[1], 1),
+                   (double)numValues / std::max(elapsed[2], 1));
+        }
+    }
+}
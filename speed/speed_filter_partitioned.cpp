@@ -0,0 +1,62 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+/*
+ * CPU time per block of a 16385 taps firls design with partitioned and plain
+ * overlap-save convolution, for some latencies (= block sizes). The real time
+ * budget is the duration of one block at 48 kHz.
+ */
+int main() {
+    const int NUMTAPS = 16385;
+    const int NUMSAMPLES = 1 << 17;
+    const int BLOCKSIZES[] = {32, 64, 128, 256, 1024};
+    const FirFloat FS = 48000.0;
+
+    // contiguous bands: well conditioned, designed by the Toeplitz solver
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.2, 0.2, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    std::vector<FirFloat> h(NUMTAPS);
+    {
+        Stopwatch s;
+        firls(h.data(), NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0);
+        int elapsed = s.elapsed();
+        printf("firls %d taps: %d us\n", NUMTAPS, elapsed);
+    }
+
+    std::vector<FirFloat> x(NUMSAMPLES);
+    for (int i = 0; i < NUMSAMPLES; i++) {
+        x[i] = std::sin(0.01 * i);
+    }
+    std::vector<FirFloat> y(NUMSAMPLES);
+
+    printf("block  budget  partitioned        fft  auto\n");
+    for (int blockSize : BLOCKSIZES) {
+        const int methods[] = {FIR_FILTER_PARTITIONED, FIR_FILTER_FFT};
+        double perBlock[2];
+        for (int m = 0; m < 2; m++) {
+            FirFilter *filter = firfilter_create_method(NUMTAPS, h.data(), methods[m], blockSize);
+            const int numBlocks = NUMSAMPLES / blockSize;
+            Stopwatch s;
+            for (int b = 0; b < numBlocks; b++) {
+                firfilter_process(filter, &x[b * blockSize], &y[b * blockSize], blockSize);
+            }
+            int elapsed = s.elapsed();
+            perBlock[m] = (double)elapsed / numBlocks;
+            firfilter_destroy(filter);
+        }
+        FirFilter *automatic =
+            firfilter_create_method(NUMTAPS, h.data(), FIR_FILTER_AUTO, blockSize);
+        const int method = firfilter_method(automatic);
+        firfilter_destroy(automatic);
+        printf("%5d %5.0f us %9.1f us %7.1f us  %s\n", blockSize, 1e6 * blockSize / FS,
+               perBlock[0], perBlock[1],
+               method == FIR_FILTER_PARTITIONED ? "partitioned"
+               : method == FIR_FILTER_FFT       ? "fft"
+                                                : "direct");
+    }
+}
@@ -1,6 +1,9 @@
 #include "fir.hpp"
 #include "stopwatch_elapsed.h"
+#include <algorithm>
+#include <cmath>
 #include <stdio.h>
+#include <vector>
 
 int main() {
     const int MAXTAPS = 1010;
@@ -12,10 +15,173 @@ int main() {
     FirFloat weight[NUMBANDS] = {1, 1};
     FirFloat h[MAXTAPS];
 
+    // wide transition band: ill-conditioned for larger filters, solved with COD
+    printf("wide transition band\n");
     for (int i = 1; i < MAXTAPS; i += 100) {
         Stopwatch s;
         firls(h, i, NUMBANDS, bands, desired, desired, weight, 1.0);
         int elapsed = s.elapsed();
-        printf("%3d: %6d us\n", i, elapsed);
+        printf("%5d: %8d us\n", i, elapsed);
     }
-}
\ No newline at end of file
+
+    // no transition band: well conditioned, solved with Levinson
+    const int MAXTAPS_LONG = 16001;
+    FirFloat bands_contiguous[2 * NUMBANDS] = {0, 0.2, 0.2, 0.5};
+    std::vector<FirFloat> h_long(MAXTAPS_LONG);
+    printf("no transition band\n");
+    for (int i = 1001; i <= MAXTAPS_LONG; i += 5000) {
+        Stopwatch s;
+        firls(h_long.data(), i, NUMBANDS, bands_contiguous, desired, desired, weight, 1.0);
+        int elapsed = s.elapsed();
+        printf("%5d: %8d us\n", i, elapsed);
+    }
+
+    // antisymmetric: a differentiator up to 0.2 with a contiguous stop band has
+    // the same (well conditioned) Toeplitz matrix as the lowpass above
+    FirFloat desiredDiffBegin[NUMBANDS] = {0, 0};
+    FirFloat desiredDiffEnd[NUMBANDS] = {0.4 * M_PI, 0};
+    printf("no transition band, lowpass vs differentiator\n");
+    for (int i = 1000; i <= MAXTAPS_LONG; i += 5000) {
+        Stopwatch s;
+        firls(h_long.data(), i, NUMBANDS, bands_contiguous, desired, desired, weight, 1.0);
+        int elapsedSymmetric = s.elapsed();
+        Stopwatch s2;
+        firls_antisymmetric(h_long.data(), i, NUMBANDS, bands_contiguous, desiredDiffBegin,
+                            desiredDiffEnd, weight, 1.0);
+        int elapsedAntisymmetric = s2.elapsed();
+        printf("%5d: %8d us %8d us\n", i, elapsedSymmetric, elapsedAntisymmetric);
+    }
+
+    // many contiguous bands (arbitrary magnitude equalizer): the q and b
+    // assembly is significant compared to the solve
+    const int NUMBANDS_EQ[] = {20, 60};
+    const int NUMDESIGNS = 200;
+    printf("equalizer, us per design\n");
+    for (int numBands : NUMBANDS_EQ) {
+        std::vector<FirFloat> bandsEq(2 * numBands);
+        std::vector<FirFloat> desiredEq(numBands + 1);
+        std::vector<FirFloat> weightEq(numBands, 1.0);
+        for (int j = 0; j < numBands; j++) {
+            bandsEq[2 * j] = 0.5 * j / numBands;
+            bandsEq[2 * j + 1] = 0.5 * (j + 1) / numBands;
+        }
+        for (int j = 0; j <= numBands; j++) {
+            desiredEq[j] = 1.0 + 0.5 * (j % 2);
+        }
+        for (int numTaps = 31; numTaps <= 511; numTaps = 2 * numTaps + 1) {
+            std::vector<char> workspace(firls_workspace_size(numTaps, numBands));
+            Stopwatch s;
+            for (int i = 0; i < NUMDESIGNS; i++) {
+                firls_ws(h_long.data(), numTaps, numBands, bandsEq.data(), desiredEq.data(),
+                         desiredEq.data() + 1, weightEq.data(), 1.0, workspace.data(),
+                         workspace.size());
+            }
+            int elapsed = s.elapsed();
+            printf("%3d bands %4d taps: %8.1f us\n", numBands, numTaps,
+                   (double)elapsed / NUMDESIGNS);
+        }
+    }
+
+    // measured magnitude curve: one band per segment against the sampled curve
+    const int NUMPOINTS[] = {500, 4000};
+    printf("sampled curve, one band per segment vs firls_sampled\n");
+    for (int numPoints : NUMPOINTS) {
+        std::vector<FirFloat> f(numPoints);
+        std::vector<FirFloat> desiredCurve(numPoints);
+        std::vector<FirFloat> weightCurve(numPoints, 1.0);
+        std::vector<FirFloat> bandsCurve(2 * (numPoints - 1));
+        for (int j = 0; j < numPoints; j++) {
+            f[j] = 0.5 * j / (numPoints - 1);
+            desiredCurve[j] = 1.0 + 0.3 * std::sin(40.0 * f[j]) + 0.1 * std::sin(300.0 * f[j]);
+        }
+        for (int j = 0; j < numPoints - 1; j++) {
+            bandsCurve[2 * j] = f[j];
+            bandsCurve[2 * j + 1] = f[j + 1];
+        }
+        for (int numTaps : {255, 1023}) {
+            Stopwatch s;
+            firls(h_long.data(), numTaps, numPoints - 1, bandsCurve.data(), desiredCurve.data(),
+                  desiredCurve.data() + 1, weightCurve.data(), 1.0);
+            int elapsedBands = s.elapsed();
+            Stopwatch s2;
+            firls_sampled(h_long.data(), numTaps, numPoints, f.data(), desiredCurve.data(),
+                          weightCurve.data(), 1.0);
+            int elapsedSampled = s2.elapsed();
+            printf("%4d points %4d taps: %8d us %8d us\n", numPoints, numTaps, elapsedBands,
+                   elapsedSampled);
+        }
+    }
+
+    // minimum number of taps for a specification: firls_minorder against
+    // trying every number of taps with firls and firfreqz
+    FirFloat deviation[NUMBANDS] = {0.001, 0.0001};
+    FirFloat weightSpec[NUMBANDS] = {1 / deviation[0], 1 / deviation[1]};
+    FirFloat bandsSpec[2 * NUMBANDS] = {0, 0.2, 0.22, 0.5};
+    const int NUMFREQS = 8193;
+    std::vector<FirFloat> F(NUMFREQS);
+    std::vector<FirFloat> H(NUMFREQS);
+    printf("minimum order, deviation %g / %g\n", deviation[0], deviation[1]);
+    {
+        Stopwatch s;
+        int numTaps = 0;
+        for (numTaps = 1; numTaps <= MAXTAPS_LONG; numTaps++) {
+            firls(h_long.data(), numTaps, NUMBANDS, bandsSpec, desired, desired, weightSpec, 1.0);
+            firfreqz(F.data(), H.data(), NUMFREQS, numTaps, h_long.data(), 1.0);
+            FirFloat edges[2] = {bandsSpec[1], bandsSpec[2]};
+            FirFloat edgeMagnitudes[2];
+            firfreqz_points(edges, edgeMagnitudes, 2, numTaps, h_long.data(), 1.0);
+            bool meets = std::fabs(edgeMagnitudes[0] - 1) <= deviation[0] &&
+                         edgeMagnitudes[1] <= deviation[1];
+            for (int i = 0; i < NUMFREQS && meets; i++) {
+                meets = !((F[i] <= bandsSpec[1] && std::fabs(H[i] - 1) > deviation[0]) ||
+                          (F[i] >= bandsSpec[2] && H[i] > deviation[1]));
+            }
+            if (meets) {
+                break;
+            }
+        }
+        int elapsed = s.elapsed();
+        printf("linear search:  %4d taps, %4d solves: %8d us\n", numTaps, numTaps, elapsed);
+    }
+    {
+        Stopwatch s;
+        int numTaps = 0;
+        int numSolves = 0;
+        firls_minorder(h_long.data(), MAXTAPS_LONG, NUMBANDS, bandsSpec, desired, desired, NULL,
+                       1.0, deviation, &numTaps, &numSolves);
+        int elapsed = s.elapsed();
+        printf("firls_minorder: %4d taps, %4d solves: %8d us\n", numTaps, numSolves, elapsed);
+    }
+
+    // narrow transition band: too ill-conditioned for Levinson, solved with a
+    // dense decomposition, parallel if built with FIR_OPENMP. Threads 1, 2, 4,
+    // ... up to the number of processors, and the speedup against 1 thread.
+    struct {
+        int numTaps;
+        FirFloat transition;
+    } large[] = {{2001, 0.0045}, {4001, 0.0022}};
+    const int numProcessors = firls_set_num_threads(0);
+    printf("narrow transition band, %d processors\n", numProcessors);
+    for (const auto &design : large) {
+        FirFloat bandsNarrow[2 * NUMBANDS] = {0, 0.2, 0.2 + design.transition, 0.5};
+        h_long.resize(design.numTaps);
+        int elapsedSingle = 0;
+        for (int numThreads = 1;; numThreads = std::min(2 * numThreads, numProcessors)) {
+            firls_set_num_threads(numThreads);
+            FirlsStats stats;
+            Stopwatch s;
+            firls_stats(h_long.data(), design.numTaps, NUMBANDS, bandsNarrow, desired, desired,
+                        weight, 1.0, &stats);
+            int elapsed = s.elapsed();
+            if (numThreads == 1) {
+                elapsedSingle = elapsed;
+            }
+            printf("%5d taps, %2d threads, solver %d: %8d us, speedup %5.2f\n", design.numTaps,
+                   numThreads, stats.solver, elapsed, (double)elapsedSingle / elapsed);
+            if (numThreads == numProcessors) {
+                break;
+            }
+        }
+    }
+    firls_set_num_threads(1);
+}
@@ -0,0 +1,84 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+int main() {
+    const int NUMFILTERS = 256;
+    const int NUMBANDS = 2;
+    const int NUMTAPS[] = {31, 101, 301};
+
+    // filter bank: low pass filters with increasing cutoff frequency
+    std::vector<FirFloat> bands(NUMFILTERS * 2 * NUMBANDS);
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    std::vector<FirlsSpec> specs(NUMFILTERS);
+    for (int i = 0; i < NUMFILTERS; i++) {
+        FirFloat cutoff = 0.05 + 0.3 * i / NUMFILTERS;
+        FirFloat *b = &bands[i * 2 * NUMBANDS];
+        b[0] = 0.0;
+        b[1] = cutoff;
+        b[2] = cutoff;
+        b[3] = 0.5;
+        specs[i] = {NUMBANDS, b, desired, desired, weight, 1.0};
+    }
+
+    int hardwareThreads = (int)std::thread::hardware_concurrency();
+    printf("%d filters, %d hardware threads\n", NUMFILTERS, hardwareThreads);
+    for (int numTaps : NUMTAPS) {
+        std::vector<FirFloat> h(NUMFILTERS * numTaps);
+        {
+            Stopwatch s;
+            for (int i = 0; i < NUMFILTERS; i++) {
+                firls(&h[i * numTaps], numTaps, NUMBANDS, specs[i].bands, desired, desired, weight,
+                      1.0);
+            }
+            int elapsed = s.elapsed();
+            printf("%3d taps, loop firls:        %8d us\n", numTaps, elapsed);
+        }
+        for (int numThreads = 1; numThreads <= hardwareThreads; numThreads *= 2) {
+            Stopwatch s;
+            firls_batch(h.data(), NUMFILTERS, numTaps, specs.data(), NULL, numThreads);
+            int elapsed = s.elapsed();
+            printf("%3d taps, batch %2d threads:  %8d us\n", numTaps, numThreads, elapsed);
+        }
+    }
+
+    // filter bank with shared band edges: every filter boosts its own band
+    // of an 8 band equalizer, solved with one factorization by firls_multi
+    const int NUMBANDS_EQ = 8;
+    std::vector<FirFloat> bandsEq(2 * NUMBANDS_EQ);
+    std::vector<FirFloat> weightEq(NUMBANDS_EQ, 1.0);
+    std::vector<FirFloat> desiredEq(NUMFILTERS * NUMBANDS_EQ);
+    for (int j = 0; j < NUMBANDS_EQ; j++) {
+        bandsEq[2 * j] = 0.5 * j / NUMBANDS_EQ;
+        bandsEq[2 * j + 1] = 0.5 * (j + 1) / NUMBANDS_EQ;
+    }
+    for (int i = 0; i < NUMFILTERS; i++) {
+        for (int j = 0; j < NUMBANDS_EQ; j++) {
+            desiredEq[i * NUMBANDS_EQ + j] = (j == i % NUMBANDS_EQ) ? 1.0 + 0.01 * i : 1.0;
+        }
+    }
+    printf("shared band edges, %d bands\n", NUMBANDS_EQ);
+    for (int numTaps : NUMTAPS) {
+        std::vector<FirFloat> h(NUMFILTERS * numTaps);
+        {
+            Stopwatch s;
+            for (int i = 0; i < NUMFILTERS; i++) {
+                const FirFloat *desired_i = &desiredEq[i * NUMBANDS_EQ];
+                firls(&h[i * numTaps], numTaps, NUMBANDS_EQ, bandsEq.data(), desired_i, desired_i,
+                      weightEq.data(), 1.0);
+            }
+            int elapsed = s.elapsed();
+            printf("%3d taps, loop firls:        %8d us\n", numTaps, elapsed);
+        }
+        {
+            Stopwatch s;
+            firls_multi(h.data(), NUMFILTERS, numTaps, NUMBANDS_EQ, bandsEq.data(),
+                        desiredEq.data(), desiredEq.data(), weightEq.data(), 1.0);
+            int elapsed = s.elapsed();
+            printf("%3d taps, firls_multi:       %8d us\n", numTaps, elapsed);
+        }
+    }
+}
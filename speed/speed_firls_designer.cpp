@@ -0,0 +1,54 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <stdio.h>
+#include <vector>
+
+/*
+ * Equalizer with one band gain changing per design: full redesign with
+ * firls_ws versus FirlsDesigner, which reuses the factorization. The first
+ * designer call includes the factorization.
+ */
+int main() {
+    const int NUMBANDS = 20;
+    const int NUMDESIGNS = 200;
+
+    std::vector<FirFloat> bands(2 * NUMBANDS);
+    std::vector<FirFloat> desired(NUMBANDS);
+    std::vector<FirFloat> weight(NUMBANDS, 1.0);
+    for (int j = 0; j < NUMBANDS; j++) {
+        bands[2 * j] = 0.5 * j / NUMBANDS;
+        bands[2 * j + 1] = 0.5 * (j + 1) / NUMBANDS;
+        desired[j] = 1.0;
+    }
+
+    printf("%d bands, us per design\n", NUMBANDS);
+    printf("taps   firls_ws  designer first  designer update\n");
+    for (int numTaps = 31; numTaps <= 1023; numTaps = 2 * numTaps + 1) {
+        std::vector<FirFloat> h(numTaps);
+        std::vector<char> workspace(firls_workspace_size(numTaps, NUMBANDS));
+        Stopwatch s;
+        for (int i = 0; i < NUMDESIGNS; i++) {
+            desired[5] = 1.0 + 0.01 * i;
+            firls_ws(h.data(), numTaps, NUMBANDS, bands.data(), desired.data(), desired.data(),
+                     weight.data(), 1.0, workspace.data(), workspace.size());
+        }
+        int elapsedFirls = s.elapsed();
+
+        FirlsDesigner *designer = firls_designer_create(numTaps);
+        Stopwatch sFirst;
+        firls_designer_design(designer, h.data(), NUMBANDS, bands.data(), desired.data(),
+                              desired.data(), weight.data(), 1.0);
+        int elapsedFirst = sFirst.elapsed();
+        Stopwatch sUpdate;
+        for (int i = 0; i < NUMDESIGNS; i++) {
+            desired[5] = 1.0 + 0.01 * i;
+            firls_designer_design(designer, h.data(), NUMBANDS, bands.data(), desired.data(),
+                                  desired.data(), weight.data(), 1.0);
+        }
+        int elapsedUpdate = sUpdate.elapsed();
+        firls_designer_destroy(designer);
+
+        printf("%4d %10.1f %15d %16.1f\n", numTaps, (double)elapsedFirls / NUMDESIGNS,
+               elapsedFirst, (double)elapsedUpdate / NUMDESIGNS);
+    }
+}
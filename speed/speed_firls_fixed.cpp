@@ -0,0 +1,106 @@
+#include "fir.hpp"
+#include "fir_fixed.hpp"
+#include "stopwatch_elapsed.h"
+#include <stdio.h>
+#include <vector>
+
+static const int NUMBANDS = 2;
+static const FirFloat BANDS[2 * NUMBANDS] = {0, 0.1, 0.2, 0.5};
+static const FirFloat DESIRED[NUMBANDS] = {1, 0};
+static const FirFloat WEIGHT[NUMBANDS] = {1, 1};
+
+/* sum of all taps, so the compiler can not drop the designs */
+static volatile FirFloat sink;
+
+/*
+ * Nanoseconds per design for the runtime firls, firls_ws with a reused
+ * workspace and the fixed size firls, and per response for the runtime
+ * firfreqz, firfreqz with a reused plan and the fixed size firfreqz.
+ */
+template <int NumTaps> static void timeDesigns(int numDesigns) {
+    FirFloat h[NumTaps];
+    FirFloat sum = 0.0;
+    int elapsedRuntime;
+    {
+        Stopwatch s;
+        for (int i = 0; i < numDesigns; i++) {
+            firls(h, NumTaps, NUMBANDS, BANDS, DESIRED, DESIRED, WEIGHT, 1.0);
+            sum += h[0];
+        }
+        elapsedRuntime = s.elapsed();
+    }
+    int elapsedWorkspace;
+    {
+        std::vector<char> workspace(firls_workspace_size(NumTaps, NUMBANDS));
+        Stopwatch s;
+        for (int i = 0; i < numDesigns; i++) {
+            firls_ws(h, NumTaps, NUMBANDS, BANDS, DESIRED, DESIRED, WEIGHT, 1.0, workspace.data(),
+                     workspace.size());
+            sum += h[0];
+        }
+        elapsedWorkspace = s.elapsed();
+    }
+    int elapsedFixed;
+    {
+        Stopwatch s;
+        for (int i = 0; i < numDesigns; i++) {
+            firls(h, BANDS, DESIRED, DESIRED, WEIGHT, 1.0);
+            sum += h[0];
+        }
+        elapsedFixed = s.elapsed();
+    }
+
+    const int NUMFREQS = 65;
+    FirFloat frequencies[NUMFREQS];
+    FirFloat magnitudes[NUMFREQS];
+    int elapsedFreqz;
+    {
+        Stopwatch s;
+        for (int i = 0; i < numDesigns; i++) {
+            firfreqz(frequencies, magnitudes, NUMFREQS, NumTaps, h, 1.0);
+            sum += magnitudes[1];
+        }
+        elapsedFreqz = s.elapsed();
+    }
+    int elapsedPlan;
+    {
+        FirFreqzPlan *plan = firfreqz_plan_create(NUMFREQS);
+        Stopwatch s;
+        for (int i = 0; i < numDesigns; i++) {
+            firfreqz_plan_execute(plan, frequencies, magnitudes, NumTaps, h, 1.0);
+            sum += magnitudes[1];
+        }
+        elapsedPlan = s.elapsed();
+        firfreqz_plan_destroy(plan);
+    }
+    int elapsedFreqzFixed;
+    {
+        Stopwatch s;
+        for (int i = 0; i < numDesigns; i++) {
+            firfreqz(frequencies, magnitudes, h, 1.0);
+            sum += magnitudes[1];
+        }
+        elapsedFreqzFixed = s.elapsed();
+    }
+    sink = sum;
+
+    printf("%4d %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f\n", NumTaps,
+           1e3 * elapsedRuntime / numDesigns, 1e3 * elapsedWorkspace / numDesigns,
+           1e3 * elapsedFixed / numDesigns, 1e3 * elapsedFreqz / numDesigns,
+           1e3 * elapsedPlan / numDesigns, 1e3 * elapsedFreqzFixed / numDesigns);
+}
+
+int main() {
+    const int NUMDESIGNS = 20000;
+    printf("ns per design, freqz at 65 points\n");
+    printf("                 firls               freqz\n");
+    printf("taps   runtime  firls_ws     fixed   runtime      plan     fixed\n");
+    timeDesigns<7>(NUMDESIGNS);
+    timeDesigns<8>(NUMDESIGNS);
+    timeDesigns<15>(NUMDESIGNS);
+    timeDesigns<16>(NUMDESIGNS);
+    timeDesigns<31>(NUMDESIGNS);
+    timeDesigns<32>(NUMDESIGNS);
+    timeDesigns<63>(NUMDESIGNS);
+    timeDesigns<64>(NUMDESIGNS);
+}
@@ -0,0 +1,64 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+/* Maximum pass band deviation from 1 and maximum stop band gain */
+static void ripple(FirFloat &passRipple, FirFloat &stopRipple, const FirFloat h[], int numTaps,
+                   FirFloat passEdge, FirFloat stopEdge) {
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    firfreqz(F, H, NUMFREQS, numTaps, h, 1.0);
+    passRipple = 0.0;
+    stopRipple = 0.0;
+    for (int i = 0; i < NUMFREQS; i++) {
+        if (F[i] <= passEdge) {
+            passRipple = std::max(passRipple, std::fabs(H[i] - 1.0));
+        }
+        if (F[i] >= stopEdge) {
+            stopRipple = std::max(stopRipple, H[i]);
+        }
+    }
+}
+
+int main() {
+    const int NUMBANDS = 2;
+    const int NUMDESIGNS = 20;
+    const FirFloat PASS = 0.2;
+    const FirFloat STOP = 0.22;
+
+    FirFloat bands[2 * NUMBANDS] = {0, PASS, STOP, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+
+    // same specification and number of taps: design time and worst case
+    // ripple of both methods
+    printf("low pass %.2f-%.2f, us per design, pass band / stop band ripple\n", PASS, STOP);
+    for (int numTaps = 25; numTaps <= 400; numTaps *= 2) {
+        std::vector<FirFloat> h(numTaps);
+        FirFloat passRipple, stopRipple;
+
+        Stopwatch sLs;
+        for (int i = 0; i < NUMDESIGNS; i++) {
+            firls(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0);
+        }
+        int elapsedLs = sLs.elapsed();
+        ripple(passRipple, stopRipple, h.data(), numTaps, PASS, STOP);
+        printf("%4d taps, firls:    %8.1f us, ripple %.2e / %.2e\n", numTaps,
+               (double)elapsedLs / NUMDESIGNS, passRipple, stopRipple);
+
+        Stopwatch sRemez;
+        int error = 0;
+        for (int i = 0; i < NUMDESIGNS; i++) {
+            error = firremez(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0);
+        }
+        int elapsedRemez = sRemez.elapsed();
+        ripple(passRipple, stopRipple, h.data(), numTaps, PASS, STOP);
+        printf("%4d taps, firremez: %8.1f us, ripple %.2e / %.2e%s\n", numTaps,
+               (double)elapsedRemez / NUMDESIGNS, passRipple, stopRipple,
+               error != 0 ? " (not converged)" : "");
+    }
+}
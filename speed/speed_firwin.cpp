@@ -0,0 +1,66 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+/* Maximum pass band deviation from 1 and maximum stop band gain */
+static void ripple(FirFloat &passRipple, FirFloat &stopRipple, const FirFloat h[], int numTaps,
+                   FirFloat passEdge, FirFloat stopEdge) {
+    const int NUMFREQS = 16385;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    firfreqz(F, H, NUMFREQS, numTaps, h, 1.0);
+    passRipple = 0.0;
+    stopRipple = 0.0;
+    for (int i = 0; i < NUMFREQS; i++) {
+        if (F[i] <= passEdge) {
+            passRipple = std::max(passRipple, std::fabs(H[i] - 1.0));
+        }
+        if (F[i] >= stopEdge) {
+            stopRipple = std::max(stopRipple, H[i]);
+        }
+    }
+}
+
+int main() {
+    const int NUMBANDS = 2;
+    const int NUMDESIGNS = 20;
+    const FirFloat ATTENUATION = 80.0;
+
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+
+    // Kaiser window design with the number of taps for 80 dB, against firls
+    // with the same number of taps. The transition band shrinks with the
+    // number of taps, so the firls designs stay well conditioned.
+    printf("low pass from 0.2, %.0f dB Kaiser window, us per design, pass band / stop band "
+           "ripple\n",
+           ATTENUATION);
+    for (int numTaps = 255; numTaps <= 4095; numTaps = 2 * numTaps + 1) {
+        const FirFloat width = (ATTENUATION - 7.95) / (14.36 * (numTaps - 1));
+        FirFloat bands[2 * NUMBANDS] = {0, 0.2, 0.2 + width, 0.5};
+        std::vector<FirFloat> h(numTaps);
+        FirFloat passRipple, stopRipple;
+
+        Stopwatch sLs;
+        for (int i = 0; i < NUMDESIGNS; i++) {
+            firls(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0);
+        }
+        int elapsedLs = sLs.elapsed();
+        ripple(passRipple, stopRipple, h.data(), numTaps, bands[1], bands[2]);
+        printf("%4d taps, firls:  %8.1f us, ripple %.2e / %.2e\n", numTaps,
+               (double)elapsedLs / NUMDESIGNS, passRipple, stopRipple);
+
+        Stopwatch sWin;
+        for (int i = 0; i < NUMDESIGNS; i++) {
+            firwin(h.data(), numTaps, NUMBANDS, bands, desired, FIR_WINDOW_KAISER, ATTENUATION,
+                   1.0);
+        }
+        int elapsedWin = sWin.elapsed();
+        ripple(passRipple, stopRipple, h.data(), numTaps, bands[1], bands[2]);
+        printf("%4d taps, firwin: %8.1f us, ripple %.2e / %.2e\n", numTaps,
+               (double)elapsedWin / NUMDESIGNS, passRipple, stopRipple);
+    }
+}
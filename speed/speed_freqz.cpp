@@ -54,6 +54,7 @@ int main(int argc, char *argv[]) {
     FirFloat frequencies[n_end];
     FirFloat magnitudes[n_end];
     FirFloat magnitudes_naive[n_end];
+    FirFloat magnitudes_points[n_end];
 
     Stopwatch s;
     firls(h, taps, NUMBANDS, bands, desired, desired, weight, 1.0);
@@ -68,6 +69,45 @@ int main(int argc, char *argv[]) {
             printf("freqz fft   %3d: %6d us\n", i, elapsed);
         }
 
+        {
+            // same without plan, calculated in float
+            float h_f[taps];
+            float frequencies_f[i];
+            float magnitudes_f[i];
+            for (int j = 0; j < taps; j++) {
+                h_f[j] = (float)h[j];
+            }
+            Stopwatch s;
+            firfreqz_f(frequencies_f, magnitudes_f, i, taps, h_f, 2.0f);
+            int elapsed = s.elapsed();
+            printf("freqz float %3d: %6d us\n", i, elapsed);
+        }
+
+        {
+            // plan creation excluded: it is done once for repeated calculations
+            FirFreqzPlan *plan = firfreqz_plan_create(i);
+            Stopwatch s;
+            firfreqz_plan_execute(plan, frequencies, magnitudes, taps, h, 2.0);
+            int elapsed = s.elapsed();
+            firfreqz_plan_destroy(plan);
+            printf("freqz plan  %3d: %6d us\n", i, elapsed);
+        }
+
+        {
+            // same filter with one tap changed: no linear phase, full size FFT
+            FirFloat h_asym[taps];
+            for (int j = 0; j < taps; j++) {
+                h_asym[j] = h[j];
+            }
+            h_asym[0] += 1e-9;
+            FirFreqzPlan *plan = firfreqz_plan_create(i);
+            Stopwatch s;
+            firfreqz_plan_execute(plan, frequencies, magnitudes_naive, taps, h_asym, 2.0);
+            int elapsed = s.elapsed();
+            firfreqz_plan_destroy(plan);
+            printf("freqz asym  %3d: %6d us\n", i, elapsed);
+        }
+
         {
             Stopwatch s;
             firfreqz_naive(frequencies, magnitudes_naive, i, taps, h, 2.0);
@@ -83,5 +123,27 @@ int main(int argc, char *argv[]) {
                         i, j, magnitudes[j], magnitudes_naive[j]);
             }
         }
+
+        // zoom in on 0 .. 0.05 * fs, with the same number of points
+        {
+            Stopwatch s;
+            firfreqz_zoom(frequencies, magnitudes, i, 0.0, 0.1, taps, h, 2.0);
+            int elapsed = s.elapsed();
+            printf("freqz zoom   %3d: %6d us\n", i, elapsed);
+        }
+
+        {
+            Stopwatch s;
+            firfreqz_points(frequencies, magnitudes_points, i, taps, h, 2.0);
+            int elapsed = s.elapsed();
+            printf("freqz points %3d: %6d us\n", i, elapsed);
+        }
+
+        for (int j = 0; j < i; j++) {
+            if (std::abs(magnitudes[j] - magnitudes_points[j]) > 1e-5) {
+                fprintf(stderr, "Oops, deviation at %d points, index %d: zoom: %lf, points: %lf\n",
+                        i, j, magnitudes[j], magnitudes_points[j]);
+            }
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,75 @@
+#include "fir.hpp"
+#include "stopwatch_elapsed.h"
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+/*
+ * Polyphase resampling versus filtering at the high sample rate with the
+ * direct form filter, followed by zero insertion / downsampling.
+ */
+int main() {
+    const int NUMSAMPLES = 1 << 18;
+    const int BLOCKSIZE = 1024;
+    const int NUMTAPS = 255;
+    const int FACTORS[][2] = {{1, 2}, {1, 4}, {1, 8}, {2, 1}, {4, 1}, {3, 2}, {2, 3}};
+
+    std::vector<FirFloat> x(NUMSAMPLES);
+    for (int i = 0; i < NUMSAMPLES; i++) {
+        x[i] = std::sin(0.01 * i);
+    }
+
+    printf("%d taps, %d input samples\n", NUMTAPS, NUMSAMPLES);
+    printf(" L/M  polyphase   filter+resample\n");
+    for (const auto &factor : FACTORS) {
+        const int L = factor[0];
+        const int M = factor[1];
+
+        // anti-alias / anti-imaging low pass filter at the high sample rate
+        const int NUMBANDS = 2;
+        const int rateChange = L > M ? L : M;
+        FirFloat bands[2 * NUMBANDS] = {0, 0.4 / rateChange, 0.5 / rateChange, 0.5};
+        FirFloat desired[NUMBANDS] = {(FirFloat)L, 0};
+        FirFloat weight[NUMBANDS] = {1, 1};
+        std::vector<FirFloat> h(NUMTAPS);
+        firls(h.data(), NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0);
+
+        std::vector<FirFloat> y((size_t)NUMSAMPLES * L / M + 1);
+        int elapsedPolyphase;
+        {
+            FirResampler *resampler = firresampler_create(L, M, NUMTAPS, h.data());
+            Stopwatch s;
+            int numOutput = 0;
+            for (int start = 0; start < NUMSAMPLES; start += BLOCKSIZE) {
+                numOutput += firresampler_process(resampler, &x[start], BLOCKSIZE, &y[numOutput]);
+            }
+            elapsedPolyphase = s.elapsed();
+            firresampler_destroy(resampler);
+        }
+
+        int elapsedFilter;
+        {
+            FirFilter *filter = firfilter_create(NUMTAPS, h.data());
+            std::vector<FirFloat> up((size_t)BLOCKSIZE * L);
+            Stopwatch s;
+            int numOutput = 0;
+            int phase = 0;
+            for (int start = 0; start < NUMSAMPLES; start += BLOCKSIZE) {
+                for (int i = 0; i < BLOCKSIZE; i++) {
+                    up[(size_t)i * L] = x[start + i];
+                    for (int j = 1; j < L; j++) {
+                        up[(size_t)i * L + j] = 0.0;
+                    }
+                }
+                firfilter_process(filter, up.data(), up.data(), BLOCKSIZE * L);
+                for (; phase < BLOCKSIZE * L; phase += M) {
+                    y[numOutput++] = up[phase];
+                }
+                phase -= BLOCKSIZE * L;
+            }
+            elapsedFilter = s.elapsed();
+            firfilter_destroy(filter);
+        }
+        printf("%2d/%-2d %8d us %12d us\n", L, M, elapsedPolyphase, elapsedFilter);
+    }
+}
@@ -5,9 +5,14 @@
  */
 
 #include "fir.hpp"
+#include "fir_fixed.hpp"
 #include "firfreqz_naive.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
 #include <gtest/gtest.h>
 #include <string.h>
+#include <vector>
 
 namespace {
 
@@ -21,6 +26,10 @@ TEST(firerror, bad_args) {
     EXPECT_TRUE(strstr(firerror(100), "Invalid") != NULL);
 }
 
+TEST(firerror, memory) {
+    EXPECT_TRUE(strstr(firerror(FIR_EMEMORY), "allocation") != NULL);
+}
+
 TEST(firls, bad_args) {
     const int NUMTAPS = 11;
     const int NUMBANDS = 2;
@@ -296,6 +305,901 @@ TEST(firls, rank_deficient2) {
     }
 }
 
+TEST(firls, stats) {
+    const int NUMBANDS = 2;
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    struct {
+        int numTaps;
+        FirFloat bands[2 * NUMBANDS];
+        int solver;
+    } cases[] = {
+        // well conditioned
+        {21, {0.0, 0.2, 0.3, 1.0}, FIR_SOLVER_LEVINSON},
+        // too ill-conditioned for Levinson, not for LDLT
+        {41, {0.0, 0.1, 0.5, 1.0}, FIR_SOLVER_LDLT},
+        // rank deficient, see rank_deficient
+        {21, {0.0, 0.1, 0.9, 1.0}, FIR_SOLVER_COD},
+    };
+    for (const auto &c : cases) {
+        FirFloat h[41];
+        FirFloat hStats[41];
+        FirlsStats stats;
+        EXPECT_EQ(firls(h, c.numTaps, NUMBANDS, c.bands, desired, desired, weight, 2.0), 0);
+        EXPECT_EQ(firls_stats(hStats, c.numTaps, NUMBANDS, c.bands, desired, desired, weight, 2.0,
+                              &stats),
+                  0);
+        EXPECT_EQ(stats.solver, c.solver);
+        EXPECT_GE(stats.condition, 1.0);
+        for (int i = 0; i < c.numTaps; i++) {
+            EXPECT_EQ(hStats[i], h[i]);
+        }
+    }
+
+    // the LDLT solution matches the extended precision design
+    long double bandsL[2 * NUMBANDS] = {0.0, 0.1, 0.5, 1.0};
+    long double desiredL[NUMBANDS] = {1, 0};
+    long double weightL[NUMBANDS] = {1, 1};
+    long double hL[41];
+    FirFloat h[41];
+    EXPECT_EQ(firls_l(hL, 41, NUMBANDS, bandsL, desiredL, desiredL, weightL, 2.0), 0);
+    EXPECT_EQ(firls_stats(h, 41, NUMBANDS, cases[1].bands, desired, desired, weight, 2.0, NULL), 0);
+    for (int i = 0; i < 41; i++) {
+        EXPECT_NEAR(h[i], (FirFloat)hL[i], 1e-5);
+    }
+}
+
+TEST(firls, threads) {
+    // narrow transition band: LDLT with one thread, LU with multiple threads
+    // if built with FIR_OPENMP
+    const int NUMTAPS = 601;
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.2, 0.214, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    static FirFloat h[NUMTAPS];
+    static FirFloat hThreads[NUMTAPS];
+    FirlsStats stats;
+
+    EXPECT_EQ(firls_set_num_threads(1), 1);
+    EXPECT_EQ(firls_stats(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0, &stats), 0);
+    EXPECT_EQ(stats.solver, FIR_SOLVER_LDLT);
+
+    int numThreads = firls_set_num_threads(4);
+    EXPECT_GE(numThreads, 1);
+    EXPECT_EQ(firls_stats(hThreads, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0,
+                          &stats),
+              0);
+    EXPECT_EQ(stats.solver, numThreads > 1 ? FIR_SOLVER_LU : FIR_SOLVER_LDLT);
+    for (int i = 0; i < NUMTAPS; i++) {
+        EXPECT_NEAR(hThreads[i], h[i], 1e-6);
+    }
+    EXPECT_GE(firls_set_num_threads(0), 1);
+    firls_set_num_threads(1);
+}
+
+TEST(firls, long_filter) {
+    // Contiguous bands give a well conditioned system, solved with Levinson
+    const int NUMTAPS = 1001;
+    const int NUMBANDS = 2;
+
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.2, 0.2, 1.0};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    static FirFloat h[NUMTAPS];
+
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+    for (int i = 0; i < NUMTAPS / 2; i++) {
+        EXPECT_EQ(h[i], h[NUMTAPS - 1 - i]);
+    }
+
+    const int NUMFREQS = 2049;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        if (F[i] < 0.18) {
+            EXPECT_NEAR(H[i], 1.0, 0.01);
+        }
+        if (F[i] > 0.22) {
+            EXPECT_LT(H[i], 0.01);
+        }
+    }
+}
+
+TEST(firls, workspace) {
+    const int NUMTAPS = 11;
+    const int NUMBANDS = 2;
+
+    FirFloat bands[2 * NUMBANDS] = {0, 0.5, 0.5, 1};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 2};
+    FirFloat h[NUMTAPS];
+    FirFloat h_ws[NUMTAPS];
+
+    EXPECT_EQ(firls_workspace_size(0, NUMBANDS), 0u);
+    size_t size = firls_workspace_size(NUMTAPS, NUMBANDS);
+    EXPECT_GT(size, 0u);
+
+    // workspace without alignment, too small and large enough
+    std::vector<char> workspace(size + 1);
+    EXPECT_EQ(firls_ws(h_ws, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0,
+                       workspace.data() + 1, size / 2),
+              FIR_EWORKSPACE);
+    EXPECT_EQ(firls_ws(h_ws, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0,
+                       workspace.data() + 1, size),
+              0);
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+    for (int i = 0; i < NUMTAPS; i++) {
+        EXPECT_EQ(h[i], h_ws[i]);
+    }
+
+    // same workspace can be reused for a rank deficient design
+    FirFloat bands2[2 * NUMBANDS] = {0.0, 0.1, 0.9, 1.0};
+    EXPECT_EQ(firls_ws(h_ws, NUMTAPS, NUMBANDS, bands2, desired, desired, weight, 2.0,
+                       workspace.data(), size),
+              0);
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands2, desired, desired, weight, 2.0), 0);
+    for (int i = 0; i < NUMTAPS; i++) {
+        EXPECT_EQ(h[i], h_ws[i]);
+    }
+}
+
+TEST(firls, batch) {
+    const int NUMTAPS = 31;
+    const int NUMBANDS = 2;
+    const int NUMFILTERS = 20;
+
+    // low pass filters with increasing cutoff frequency
+    FirFloat bands[NUMFILTERS][2 * NUMBANDS];
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    FirlsSpec specs[NUMFILTERS];
+    for (int i = 0; i < NUMFILTERS; i++) {
+        FirFloat cutoff = 0.1 + 0.03 * i;
+        bands[i][0] = 0.0;
+        bands[i][1] = cutoff;
+        bands[i][2] = cutoff + 0.1;
+        bands[i][3] = 1.0;
+        specs[i] = {NUMBANDS, bands[i], desired, desired, weight, 2.0};
+    }
+
+    FirFloat h[NUMFILTERS * NUMTAPS];
+    int status[NUMFILTERS];
+    for (int numThreads = 0; numThreads <= 3; numThreads++) {
+        EXPECT_EQ(firls_batch(h, NUMFILTERS, NUMTAPS, specs, status, numThreads), 0);
+        for (int i = 0; i < NUMFILTERS; i++) {
+            EXPECT_EQ(status[i], 0);
+            FirFloat h_single[NUMTAPS];
+            EXPECT_EQ(firls(h_single, NUMTAPS, NUMBANDS, bands[i], desired, desired, weight, 2.0),
+                      0);
+            for (int j = 0; j < NUMTAPS; j++) {
+                EXPECT_EQ(h[i * NUMTAPS + j], h_single[j]);
+            }
+        }
+    }
+
+    // one bad specification: reported in status and return value
+    FirFloat weight_negative[NUMBANDS] = {1, -1};
+    specs[5].weight = weight_negative;
+    EXPECT_EQ(firls_batch(h, NUMFILTERS, NUMTAPS, specs, status, 2), FIR_EWEIGHTS);
+    EXPECT_EQ(status[4], 0);
+    EXPECT_EQ(status[5], FIR_EWEIGHTS);
+    EXPECT_EQ(firls_batch(h, NUMFILTERS, NUMTAPS, specs, NULL, 2), FIR_EWEIGHTS);
+    EXPECT_EQ(firls_batch(h, NUMFILTERS, 0, specs, NULL, 2), FIR_ENUMTAPS);
+}
+
+TEST(firls, designer) {
+    const int NUMBANDS = 3;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.2, 0.3, 0.6, 0.7, 1};
+    FirFloat weight[NUMBANDS] = {1, 2, 1};
+    FirFloat desiredBegin[NUMBANDS] = {1, 0.5, 1};
+    FirFloat desiredEnd[NUMBANDS] = {1, 0.5, 0.2};
+
+    for (int numTaps : {1, 30, 31}) {
+        FirlsDesigner *designer = firls_designer_create(numTaps);
+        ASSERT_TRUE(designer != NULL);
+        std::vector<FirFloat> h(numTaps);
+        std::vector<FirFloat> h_designer(numTaps);
+        // gain changes of the middle band reuse the factorization, then a weight change
+        for (int step = 0; step < 6; step++) {
+            desiredBegin[1] = desiredEnd[1] = 0.5 + 0.3 * step;
+            weight[2] = (step < 4) ? 1.0 : 3.0;
+            EXPECT_EQ(firls(h.data(), numTaps, NUMBANDS, bands, desiredBegin, desiredEnd, weight,
+                            2.0),
+                      0);
+            EXPECT_EQ(firls_designer_design(designer, h_designer.data(), NUMBANDS, bands,
+                                            desiredBegin, desiredEnd, weight, 2.0),
+                      0);
+            for (int i = 0; i < numTaps; i++) {
+                EXPECT_NEAR(h_designer[i], h[i], 1e-10) << numTaps << " taps, step " << step;
+            }
+        }
+        firls_designer_destroy(designer);
+    }
+
+    // rank deficient: the designer uses the same fallback as firls
+    const int NUMTAPS = 21;
+    FirFloat bands_deficient[4] = {0.0, 0.1, 0.9, 1.0};
+    FirFloat desired[2] = {1, 0};
+    FirFloat h[NUMTAPS];
+    FirFloat h_designer[NUMTAPS];
+    FirlsDesigner *designer = firls_designer_create(NUMTAPS);
+    EXPECT_EQ(firls(h, NUMTAPS, 2, bands_deficient, desired, desired, weight, 2.0), 0);
+    EXPECT_EQ(firls_designer_design(designer, h_designer, 2, bands_deficient, desired, desired,
+                                    weight, 2.0),
+              0);
+    for (int i = 0; i < NUMTAPS; i++) {
+        EXPECT_NEAR(h_designer[i], h[i], 1e-8);
+    }
+
+    // errors invalidate the cache, a next valid design succeeds
+    FirFloat weight_negative[2] = {1, -1};
+    EXPECT_EQ(firls_designer_design(designer, h_designer, 2, bands_deficient, desired, desired,
+                                    weight_negative, 2.0),
+              FIR_EWEIGHTS);
+    EXPECT_EQ(firls_designer_design(designer, h_designer, 0, bands_deficient, desired, desired,
+                                    weight, 2.0),
+              FIR_ENUMBANDS);
+    EXPECT_EQ(firls_designer_design(designer, h_designer, 2, bands_deficient, desired, desired,
+                                    weight, 0.0),
+              FIR_EFREQUENCY);
+    EXPECT_EQ(firls_designer_design(designer, h_designer, 2, bands_deficient, desired, desired,
+                                    weight, 2.0),
+              0);
+    firls_designer_destroy(designer);
+    EXPECT_TRUE(firls_designer_create(0) == NULL);
+}
+
+TEST(firls, designer_stats) {
+    // the designer reports the solver of firls_stats: Levinson, LDLT and COD
+    const int NUMBANDS = 2;
+    struct {
+        int numTaps;
+        FirFloat bands[2 * NUMBANDS];
+        int solver;
+    } cases[] = {
+        {101, {0.0, 0.2, 0.3, 1.0}, FIR_SOLVER_LEVINSON},
+        {601, {0.0, 0.4, 0.428, 1.0}, FIR_SOLVER_LDLT},
+        {21, {0.0, 0.1, 0.9, 1.0}, FIR_SOLVER_COD},
+    };
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    firls_set_num_threads(1);
+    for (const auto &c : cases) {
+        std::vector<FirFloat> h(c.numTaps);
+        std::vector<FirFloat> h_designer(c.numTaps);
+        FirlsStats stats;
+        FirlsStats designerStats;
+        EXPECT_EQ(firls_stats(h.data(), c.numTaps, NUMBANDS, c.bands, desired, desired, weight,
+                              2.0, &stats),
+                  0);
+        EXPECT_EQ(stats.solver, c.solver);
+
+        FirlsDesigner *designer = firls_designer_create(c.numTaps);
+        EXPECT_EQ(firls_designer_stats(designer, &designerStats), -1);
+        EXPECT_EQ(firls_designer_design(designer, h_designer.data(), NUMBANDS, c.bands, desired,
+                                        desired, weight, 2.0),
+                  0);
+        EXPECT_EQ(firls_designer_stats(designer, &designerStats), 0);
+        EXPECT_EQ(designerStats.solver, stats.solver) << c.numTaps << " taps";
+        if (c.solver != FIR_SOLVER_COD) {
+            EXPECT_NEAR(designerStats.condition, stats.condition, 1e-6 * stats.condition);
+        }
+        for (int i = 0; i < c.numTaps; i++) {
+            EXPECT_NEAR(h_designer[i], h[i], 1e-8) << c.numTaps << " taps, index " << i;
+        }
+        firls_designer_destroy(designer);
+    }
+    EXPECT_EQ(firls_designer_stats(NULL, NULL), -1);
+}
+
+TEST(firls, multi) {
+    const int NUMBANDS = 3;
+    const int NUMFILTERS = 5;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.2, 0.3, 0.6, 0.7, 1};
+    FirFloat weight[NUMBANDS] = {1, 2, 1};
+    FirFloat desiredBegin[NUMFILTERS * NUMBANDS];
+    FirFloat desiredEnd[NUMFILTERS * NUMBANDS];
+    for (int k = 0; k < NUMFILTERS; k++) {
+        for (int j = 0; j < NUMBANDS; j++) {
+            desiredBegin[k * NUMBANDS + j] = 1.0 + 0.1 * k * j;
+            desiredEnd[k * NUMBANDS + j] = 1.0 - 0.2 * k + 0.3 * j;
+        }
+    }
+
+    for (int numTaps : {1, 30, 31}) {
+        std::vector<FirFloat> h(NUMFILTERS * numTaps);
+        EXPECT_EQ(firls_multi(h.data(), NUMFILTERS, numTaps, NUMBANDS, bands, desiredBegin,
+                              desiredEnd, weight, 2.0),
+                  0);
+        for (int k = 0; k < NUMFILTERS; k++) {
+            std::vector<FirFloat> h_single(numTaps);
+            EXPECT_EQ(firls(h_single.data(), numTaps, NUMBANDS, bands, desiredBegin + k * NUMBANDS,
+                            desiredEnd + k * NUMBANDS, weight, 2.0),
+                      0);
+            for (int i = 0; i < numTaps; i++) {
+                EXPECT_NEAR(h[k * numTaps + i], h_single[i], 1e-10);
+            }
+        }
+    }
+
+    FirFloat h[NUMFILTERS * 11];
+    FirFloat weight_negative[NUMBANDS] = {1, -1, 1};
+    EXPECT_EQ(firls_multi(h, NUMFILTERS, 11, NUMBANDS, bands, desiredBegin, desiredEnd,
+                          weight_negative, 2.0),
+              FIR_EWEIGHTS);
+    EXPECT_EQ(firls_multi(h, NUMFILTERS, 0, NUMBANDS, bands, desiredBegin, desiredEnd, weight, 2.0),
+              FIR_ENUMTAPS);
+    EXPECT_EQ(firls_multi(h, 0, 11, NUMBANDS, bands, desiredBegin, desiredEnd, weight, 2.0), 0);
+}
+
+TEST(firls, precision) {
+    const int NUMTAPS = 31;
+    const int NUMBANDS = 2;
+    const int NUMFREQS = 64;
+
+    FirFloat bands[2 * NUMBANDS] = {0, 0.3, 0.4, 1};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 2};
+    float bands_f[2 * NUMBANDS] = {0, 0.3f, 0.4f, 1};
+    float desired_f[NUMBANDS] = {1, 0};
+    float weight_f[NUMBANDS] = {1, 2};
+    long double bands_l[2 * NUMBANDS] = {0, 0.3L, 0.4L, 1};
+    long double desired_l[NUMBANDS] = {1, 0};
+    long double weight_l[NUMBANDS] = {1, 2};
+
+    FirFloat h[NUMTAPS];
+    float h_f[NUMTAPS];
+    long double h_l[NUMTAPS];
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+    EXPECT_EQ(firls_f(h_f, NUMTAPS, NUMBANDS, bands_f, desired_f, desired_f, weight_f, 2.0f), 0);
+    EXPECT_EQ(firls_l(h_l, NUMTAPS, NUMBANDS, bands_l, desired_l, desired_l, weight_l, 2.0L), 0);
+    for (int i = 0; i < NUMTAPS; i++) {
+        // float band edges differ from the double ones in the last bits
+        EXPECT_NEAR(h_f[i], h[i], 1e-6);
+        EXPECT_NEAR((double)h_l[i], h[i], 1e-12);
+    }
+
+    // same argument checks for all precisions
+    float weight_f_negative[NUMBANDS] = {1, -1};
+    EXPECT_EQ(firls_f(h_f, NUMTAPS, NUMBANDS, bands_f, desired_f, desired_f, weight_f_negative,
+                      2.0f),
+              FIR_EWEIGHTS);
+    EXPECT_EQ(firls_l(h_l, 0, NUMBANDS, bands_l, desired_l, desired_l, weight_l, 2.0L),
+              FIR_ENUMTAPS);
+
+    FirFloat frequencies[NUMFREQS];
+    FirFloat magnitudes[NUMFREQS];
+    float frequencies_f[NUMFREQS];
+    float magnitudes_f[NUMFREQS];
+    EXPECT_EQ(firfreqz(frequencies, magnitudes, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    EXPECT_EQ(firfreqz_f(frequencies_f, magnitudes_f, NUMFREQS, NUMTAPS, h_f, 2.0f), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        EXPECT_NEAR(frequencies_f[i], frequencies[i], 1e-6);
+        EXPECT_NEAR(magnitudes_f[i], magnitudes[i], 1e-5);
+    }
+    EXPECT_EQ(firfreqz_f(frequencies_f, magnitudes_f, 0, NUMTAPS, h_f, 2.0f), -1);
+}
+
+TEST(freqz, single_precision_symmetric) {
+    // symmetric taps of type I and II take the half size FFT for odd n, also in float
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.3, 0.4, 1};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 2};
+    const int numTapsCases[] = {31, 32};
+    const int numFreqsCases[] = {63, 65, 129};
+    for (int numTaps : numTapsCases) {
+        FirFloat h[32];
+        float h_f[32];
+        EXPECT_EQ(firls(h, numTaps, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+        std::copy(h, h + numTaps, h_f);
+        for (int n : numFreqsCases) {
+            FirFloat frequencies[129];
+            FirFloat magnitudes[129];
+            float frequencies_f[129];
+            float magnitudes_f[129];
+            EXPECT_EQ(firfreqz(frequencies, magnitudes, n, numTaps, h, 2.0), 0);
+            EXPECT_EQ(firfreqz_f(frequencies_f, magnitudes_f, n, numTaps, h_f, 2.0f), 0);
+            for (int i = 0; i < n; i++) {
+                EXPECT_NEAR(frequencies_f[i], frequencies[i], 1e-6);
+                EXPECT_NEAR(magnitudes_f[i], magnitudes[i], 1e-5) << numTaps << " taps, n " << n;
+            }
+        }
+    }
+}
+
+/* compare the fixed size design with the runtime design, and their frequency responses */
+template <int NumTaps, int NumBands>
+static void expectFixedEqual(const FirFloat (&bands)[2 * NumBands],
+                             const FirFloat (&desiredBegin)[NumBands],
+                             const FirFloat (&desiredEnd)[NumBands],
+                             const FirFloat (&weight)[NumBands], double tolerance) {
+    FirFloat h[NumTaps];
+    FirFloat h_fixed[NumTaps];
+    EXPECT_EQ(firls(h, NumTaps, NumBands, bands, desiredBegin, desiredEnd, weight, 2.0), 0);
+    EXPECT_EQ((firls<NumTaps, NumBands>(h_fixed, bands, desiredBegin, desiredEnd, weight, 2.0)),
+              0);
+    for (int i = 0; i < NumTaps; i++) {
+        EXPECT_NEAR(h_fixed[i], h[i], tolerance) << NumTaps << " taps, index " << i;
+    }
+
+    const int NUMFREQS = 129;
+    FirFloat frequencies[NUMFREQS];
+    FirFloat magnitudes[NUMFREQS];
+    FirFloat frequencies_fixed[NUMFREQS];
+    FirFloat magnitudes_fixed[NUMFREQS];
+    EXPECT_EQ(firfreqz(frequencies, magnitudes, NUMFREQS, NumTaps, h, 2.0), 0);
+    EXPECT_EQ(firfreqz(frequencies_fixed, magnitudes_fixed, h, 2.0), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        EXPECT_NEAR(frequencies_fixed[i], frequencies[i], 1e-12);
+        EXPECT_NEAR(magnitudes_fixed[i], magnitudes[i], 1e-10);
+    }
+}
+
+TEST(firls, fixed) {
+    const FirFloat bands[4] = {0, 0.3, 0.4, 1};
+    const FirFloat desired[2] = {1, 0};
+    const FirFloat weight[2] = {1, 2};
+    expectFixedEqual<1, 2>(bands, desired, desired, weight, 1e-10);
+    expectFixedEqual<2, 2>(bands, desired, desired, weight, 1e-10);
+    expectFixedEqual<7, 2>(bands, desired, desired, weight, 1e-10);
+    expectFixedEqual<30, 2>(bands, desired, desired, weight, 1e-10);
+    expectFixedEqual<63, 2>(bands, desired, desired, weight, 1e-10);
+
+    // linear changes of the desired response, three bands
+    const FirFloat bands3[6] = {0, 0.2, 0.3, 0.6, 0.7, 1};
+    const FirFloat desiredBegin3[3] = {0, 1, 0.5};
+    const FirFloat desiredEnd3[3] = {1, 1, 0};
+    const FirFloat weight3[3] = {1, 1, 3};
+    expectFixedEqual<31, 3>(bands3, desiredBegin3, desiredEnd3, weight3, 1e-10);
+    expectFixedEqual<32, 3>(bands3, desiredBegin3, desiredEnd3, weight3, 1e-10);
+
+    // equalizer with many contiguous bands: the runtime firls evaluates the
+    // sin and cos terms with a recurrence over several resynchronizations
+    const int NUMBANDS_EQ = 20;
+    FirFloat bandsEq[2 * NUMBANDS_EQ];
+    FirFloat desiredBeginEq[NUMBANDS_EQ];
+    FirFloat desiredEndEq[NUMBANDS_EQ];
+    FirFloat weightEq[NUMBANDS_EQ];
+    for (int j = 0; j < NUMBANDS_EQ; j++) {
+        bandsEq[2 * j] = (FirFloat)j / NUMBANDS_EQ;
+        bandsEq[2 * j + 1] = (FirFloat)(j + 1) / NUMBANDS_EQ;
+        desiredBeginEq[j] = 1.0 + 0.5 * std::sin(j);
+        desiredEndEq[j] = 1.0 + 0.5 * std::sin(j + 1);
+        weightEq[j] = 1.0 + (j % 3);
+    }
+    expectFixedEqual<127, NUMBANDS_EQ>(bandsEq, desiredBeginEq, desiredEndEq, weightEq, 1e-10);
+    expectFixedEqual<128, NUMBANDS_EQ>(bandsEq, desiredBeginEq, desiredEndEq, weightEq, 1e-10);
+
+    // rank deficient: the taps are not unique, check the response in the bands
+    const FirFloat bands_deficient[4] = {0, 0.1, 0.9, 1};
+    FirFloat h_deficient[21];
+    FirFloat F[512];
+    FirFloat H[512];
+    EXPECT_EQ(firls(h_deficient, bands_deficient, desired, desired, weight, 2.0), 0);
+    EXPECT_EQ(firfreqz(F, H, h_deficient, 2.0), 0);
+    for (int i = 0; i < 2; i++) {
+        EXPECT_GT(H[i], 0.99999);
+        EXPECT_LT(H[511 - i], 0.00001);
+    }
+
+    FirFloat h[11];
+    const FirFloat weight_negative[2] = {1, -1};
+    const FirFloat bands_bad[4] = {0.3, 0.2, 0.4, 1};
+    EXPECT_EQ(firls(h, bands, desired, desired, weight_negative, 2.0), FIR_EWEIGHTS);
+    EXPECT_EQ(firls(h, bands_bad, desired, desired, weight, 2.0), FIR_EBANDS);
+    EXPECT_EQ(firls(h, bands, desired, desired, weight, 0.0), FIR_EFREQUENCY);
+}
+
+TEST(firls, minorder) {
+    const int MAXTAPS = 301;
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.2, 0.25, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat deviation[NUMBANDS] = {0.01, 0.001};
+    FirFloat weight[NUMBANDS] = {1 / deviation[0], 1 / deviation[1]};
+    FirFloat h[MAXTAPS];
+    int numTaps = 0;
+    int numSolves = 0;
+    EXPECT_EQ(firls_minorder(h, MAXTAPS, NUMBANDS, bands, desired, desired, NULL, 1.0, deviation,
+                             &numTaps, &numSolves),
+              0);
+    EXPECT_GT(numTaps, 1);
+    EXPECT_LT(numSolves, 12);
+
+    // the result is the firls design, which meets the specification with
+    // numTaps taps, but not with one tap less
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    FirFloat hLs[MAXTAPS];
+    for (int n : {numTaps - 1, numTaps}) {
+        EXPECT_EQ(firls(hLs, n, NUMBANDS, bands, desired, desired, weight, 1.0), 0);
+        EXPECT_EQ(firfreqz(F, H, NUMFREQS, n, hLs, 1.0), 0);
+        bool meets = true;
+        for (int i = 0; i < NUMFREQS; i++) {
+            if ((F[i] <= 0.2 && std::fabs(H[i] - 1.0) > deviation[0]) ||
+                (F[i] >= 0.25 && H[i] > deviation[1])) {
+                meets = false;
+            }
+        }
+        EXPECT_EQ(meets, n == numTaps);
+    }
+    for (int i = 0; i < numTaps; i++) {
+        EXPECT_NEAR(h[i], hLs[i], 1e-9);
+    }
+
+    // not possible with 21 taps, or with a zero deviation
+    EXPECT_EQ(firls_minorder(h, 21, NUMBANDS, bands, desired, desired, NULL, 1.0, deviation,
+                             &numTaps, NULL),
+              FIR_ESPEC);
+    FirFloat deviation_zero[NUMBANDS] = {0.01, 0.0};
+    EXPECT_EQ(firls_minorder(h, MAXTAPS, NUMBANDS, bands, desired, desired, NULL, 1.0,
+                             deviation_zero, NULL, NULL),
+              FIR_ESPEC);
+}
+
+/* Maximum deviation of the magnitude from desired, over the frequencies in [begin, end] */
+static FirFloat maxDeviation(const FirFloat F[], const FirFloat H[], int n, FirFloat begin,
+                             FirFloat end, FirFloat desired) {
+    FirFloat deviation = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (F[i] >= begin && F[i] <= end) {
+            deviation = std::max(deviation, std::fabs(H[i] - desired));
+        }
+    }
+    return deviation;
+}
+
+TEST(firremez, bad_args) {
+    const int NUMTAPS = 11;
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.1, 0.2, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    FirFloat result[NUMTAPS] = {};
+
+    EXPECT_EQ(firremez(result, 0, NUMBANDS, bands, desired, desired, weight, 1.0), FIR_ENUMTAPS);
+    EXPECT_EQ(firremez(result, NUMTAPS, 0, bands, desired, desired, weight, 1.0), FIR_ENUMBANDS);
+    EXPECT_EQ(firremez(result, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 0.0),
+              FIR_EFREQUENCY);
+    FirFloat bands_non_monotonic[2 * NUMBANDS] = {0.0, 0.2, 0.1, 0.5};
+    EXPECT_EQ(firremez(result, NUMTAPS, NUMBANDS, bands_non_monotonic, desired, desired, weight,
+                       1.0),
+              FIR_EBANDS);
+    // unlike firls, zero weights are not allowed
+    FirFloat weight_zero[NUMBANDS] = {1, 0};
+    EXPECT_EQ(firremez(result, NUMTAPS, NUMBANDS, bands, desired, desired, weight_zero, 1.0),
+              FIR_EWEIGHTS);
+    EXPECT_TRUE(strstr(firerror(FIR_ECONVERGENCE), "converge") != NULL);
+}
+
+TEST(firremez, lowpass) {
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.2, 0.25, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 10};
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+
+    for (int numTaps : {31, 32, 61}) {
+        std::vector<FirFloat> h(numTaps);
+        std::vector<FirFloat> hLs(numTaps);
+        EXPECT_EQ(firremez(h.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0), 0);
+        for (int i = 0; i < numTaps / 2; i++) {
+            EXPECT_EQ(h[i], h[numTaps - 1 - i]);
+        }
+        EXPECT_EQ(firfreqz(F, H, NUMFREQS, numTaps, h.data(), 1.0), 0);
+        FirFloat pass = maxDeviation(F, H, NUMFREQS, 0.0, 0.2, 1.0);
+        FirFloat stop = maxDeviation(F, H, NUMFREQS, 0.25, 0.5, 0.0);
+
+        // equiripple: the weighted deviations are equal
+        EXPECT_NEAR(pass / stop, 10.0, 0.2);
+
+        // lower worst case weighted deviation than least squares
+        EXPECT_EQ(firls(hLs.data(), numTaps, NUMBANDS, bands, desired, desired, weight, 1.0), 0);
+        EXPECT_EQ(firfreqz(F, H, NUMFREQS, numTaps, hLs.data(), 1.0), 0);
+        FirFloat passLs = maxDeviation(F, H, NUMFREQS, 0.0, 0.2, 1.0);
+        FirFloat stopLs = maxDeviation(F, H, NUMFREQS, 0.25, 0.5, 0.0);
+        EXPECT_LT(std::max(pass, 10 * stop), std::max(passLs, 10 * stopLs));
+    }
+}
+
+TEST(firremez, bandpass) {
+    const int NUMTAPS = 51;
+    const int NUMBANDS = 3;
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.1, 0.15, 0.3, 0.35, 0.5};
+    FirFloat desired[NUMBANDS] = {0, 1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1, 1};
+    FirFloat h[NUMTAPS];
+    EXPECT_EQ(firremez(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0), 0);
+
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 1.0), 0);
+    FirFloat stop1 = maxDeviation(F, H, NUMFREQS, 0.0, 0.1, 0.0);
+    FirFloat pass = maxDeviation(F, H, NUMFREQS, 0.15, 0.3, 1.0);
+    FirFloat stop2 = maxDeviation(F, H, NUMFREQS, 0.35, 0.5, 0.0);
+    EXPECT_LT(pass, 0.006);
+    EXPECT_NEAR(stop1, pass, 0.02 * pass);
+    EXPECT_NEAR(stop2, pass, 0.02 * pass);
+}
+
+TEST(firls, antisymmetric_full_band) {
+    // over the full band with a constant weight, Q is the identity matrix and
+    // the design is the truncated ideal impulse response
+    const int NUMBANDS = 1;
+    const FirFloat bands[2 * NUMBANDS] = {0, 1};
+    const FirFloat weight[NUMBANDS] = {1};
+    const FirFloat hilbert[NUMBANDS] = {-1};
+    const FirFloat differentiatorBegin[NUMBANDS] = {0};
+    const FirFloat differentiatorEnd[NUMBANDS] = {M_PI};
+
+    // type III: h[c + k] = 2/πk for odd k, and 0 for even k
+    const int NUMTAPS3 = 21;
+    const int C3 = NUMTAPS3 / 2;
+    FirFloat h[NUMTAPS3 + 1];
+    EXPECT_EQ(firls_antisymmetric(h, NUMTAPS3, NUMBANDS, bands, hilbert, hilbert, weight, 2.0), 0);
+    EXPECT_EQ(h[C3], 0.0);
+    for (int k = 1; k <= C3; k++) {
+        FirFloat expected = (k % 2 == 1) ? 2 / (M_PI * k) : 0.0;
+        EXPECT_NEAR(h[C3 + k], expected, 1e-12);
+        EXPECT_NEAR(h[C3 - k], -expected, 1e-12);
+    }
+
+    // type IV: h[c + k] = 1/πk for k = ±0.5, ±1.5, ...
+    const int NUMTAPS4 = 22;
+    EXPECT_EQ(firls_antisymmetric(h, NUMTAPS4, NUMBANDS, bands, hilbert, hilbert, weight, 2.0), 0);
+    for (int i = 0; i < NUMTAPS4; i++) {
+        FirFloat k = i - (NUMTAPS4 - 1) / 2.0;
+        EXPECT_NEAR(h[i], 1 / (M_PI * k), 1e-12);
+    }
+
+    // differentiator: h[c + k] = cos(πk)/k
+    EXPECT_EQ(firls_antisymmetric(h, NUMTAPS3, NUMBANDS, bands, differentiatorBegin,
+                                  differentiatorEnd, weight, 2.0),
+              0);
+    EXPECT_EQ(h[C3], 0.0);
+    for (int k = 1; k <= C3; k++) {
+        EXPECT_NEAR(h[C3 + k], std::cos(M_PI * k) / k, 1e-12);
+        EXPECT_NEAR(h[C3 - k], -std::cos(M_PI * k) / k, 1e-12);
+    }
+}
+
+TEST(firls, antisymmetric) {
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+
+    // Hilbert transformer, type III and IV. 301 taps is too many for the
+    // bands, and uses the Toeplitz minus Hankel fallback.
+    const int NUMBANDS = 1;
+    const FirFloat bands[2 * NUMBANDS] = {0.05, 0.95};
+    const FirFloat hilbert[NUMBANDS] = {-1};
+    const FirFloat weight[NUMBANDS] = {1};
+    for (int numTaps : {31, 32, 301}) {
+        std::vector<FirFloat> h(numTaps);
+        EXPECT_EQ(firls_antisymmetric(h.data(), numTaps, NUMBANDS, bands, hilbert, hilbert,
+                                      weight, 2.0),
+                  0);
+        for (int i = 0; i < numTaps; i++) {
+            EXPECT_EQ(h[i], -h[numTaps - 1 - i]);
+        }
+        EXPECT_EQ(firfreqz(F, H, NUMFREQS, numTaps, h.data(), 2.0), 0);
+        FirFloat limit = (numTaps == 301) ? 1e-6 : 0.11;
+        EXPECT_LT(maxDeviation(F, H, NUMFREQS, 0.05, 0.95, 1.0), limit);
+        EXPECT_LT(H[0], 1e-12);
+    }
+
+    // differentiator up to 0.8 * nyquist, |H| = ω
+    const FirFloat bandsDiff[2 * NUMBANDS] = {0, 0.8};
+    const FirFloat desiredBegin[NUMBANDS] = {0};
+    const FirFloat desiredEnd[NUMBANDS] = {0.8 * M_PI};
+    const int NUMTAPS = 30;
+    FirFloat h[NUMTAPS];
+    EXPECT_EQ(firls_antisymmetric(h, NUMTAPS, NUMBANDS, bandsDiff, desiredBegin, desiredEnd,
+                                  weight, 2.0),
+              0);
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        if (F[i] <= 0.8) {
+            EXPECT_NEAR(H[i], M_PI * F[i], 0.01);
+        }
+    }
+
+    EXPECT_EQ(firls_antisymmetric(h, 0, NUMBANDS, bands, hilbert, hilbert, weight, 2.0),
+              FIR_ENUMTAPS);
+    EXPECT_EQ(firls_antisymmetric(h, NUMTAPS, NUMBANDS, bands, hilbert, hilbert, weight, 0.0),
+              FIR_EFREQUENCY);
+}
+
+TEST(firls, sampled) {
+    const int NUMBANDS = 2;
+    const int NUMPOINTS = 6;
+    FirFloat h[22];
+    FirFloat hSampled[22];
+    for (int numTaps : {21, 22}) {
+        // two bands, and zero weight in the transition band
+        const FirFloat bands[2 * NUMBANDS] = {0, 0.25, 0.375, 1};
+        const FirFloat desired[NUMBANDS] = {1, 0};
+        const FirFloat weight[NUMBANDS] = {1, 10};
+        const FirFloat points[NUMPOINTS] = {0, 0.25, 0.25, 0.375, 0.375, 1};
+        const FirFloat desiredPoints[NUMPOINTS] = {1, 1, 0, 0, 0, 0};
+        const FirFloat weightPoints[NUMPOINTS] = {1, 1, 0, 0, 10, 10};
+        EXPECT_EQ(firls(h, numTaps, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+        EXPECT_EQ(firls_sampled(hSampled, numTaps, NUMPOINTS, points, desiredPoints, weightPoints,
+                                2.0),
+                  0);
+        for (int i = 0; i < numTaps; i++) {
+            EXPECT_NEAR(hSampled[i], h[i], 1e-5);
+        }
+
+        // linear desired, edges between the grid points
+        const FirFloat bandsLinear[2 * NUMBANDS] = {0, 0.2, 0.3, 0.9};
+        const FirFloat desiredBegin[NUMBANDS] = {1, 0.5};
+        const FirFloat desiredEnd[NUMBANDS] = {0.5, 0};
+        const FirFloat weightLinear[NUMBANDS] = {1, 3};
+        const FirFloat pointsLinear[NUMPOINTS] = {0, 0.2, 0.2, 0.3, 0.3, 0.9};
+        const FirFloat desiredLinear[NUMPOINTS] = {1, 0.5, 0, 0, 0.5, 0};
+        const FirFloat weightPointsLinear[NUMPOINTS] = {1, 1, 0, 0, 3, 3};
+        EXPECT_EQ(firls(h, numTaps, NUMBANDS, bandsLinear, desiredBegin, desiredEnd, weightLinear,
+                        2.0),
+                  0);
+        EXPECT_EQ(firls_sampled(hSampled, numTaps, NUMPOINTS, pointsLinear, desiredLinear,
+                                weightPointsLinear, 2.0),
+                  0);
+        for (int i = 0; i < numTaps; i++) {
+            EXPECT_NEAR(hSampled[i], h[i], 1e-4);
+        }
+    }
+
+    // smooth curve with many points, against one band per segment
+    const int NUMTAPS = 101;
+    const int NUMCURVE = 2000;
+    std::vector<FirFloat> f(NUMCURVE);
+    std::vector<FirFloat> desiredCurve(NUMCURVE);
+    std::vector<FirFloat> weightCurve(NUMCURVE, 1.0);
+    std::vector<FirFloat> bandsCurve(2 * (NUMCURVE - 1));
+    for (int i = 0; i < NUMCURVE; i++) {
+        f[i] = (FirFloat)i / (NUMCURVE - 1);
+        desiredCurve[i] = 1 + 0.5 * std::sin(7 * f[i]);
+    }
+    for (int i = 0; i < NUMCURVE - 1; i++) {
+        bandsCurve[2 * i] = f[i];
+        bandsCurve[2 * i + 1] = f[i + 1];
+    }
+    std::vector<FirFloat> hCurve(NUMTAPS);
+    std::vector<FirFloat> hCurveSampled(NUMTAPS);
+    EXPECT_EQ(firls(hCurve.data(), NUMTAPS, NUMCURVE - 1, bandsCurve.data(), desiredCurve.data(),
+                    desiredCurve.data() + 1, weightCurve.data(), 2.0),
+              0);
+    EXPECT_EQ(firls_sampled(hCurveSampled.data(), NUMTAPS, NUMCURVE, f.data(), desiredCurve.data(),
+                            weightCurve.data(), 2.0),
+              0);
+    for (int i = 0; i < NUMTAPS; i++) {
+        EXPECT_NEAR(hCurveSampled[i], hCurve[i], 1e-7);
+    }
+
+    const FirFloat points[3] = {0, 0.5, 1};
+    const FirFloat pointsBad[3] = {0, 0.6, 0.5};
+    const FirFloat ones[3] = {1, 1, 1};
+    const FirFloat weightNegative[3] = {1, -1, 1};
+    EXPECT_EQ(firls_sampled(h, 0, 3, points, ones, ones, 2.0), FIR_ENUMTAPS);
+    EXPECT_EQ(firls_sampled(h, 21, 3, points, ones, ones, 0.0), FIR_EFREQUENCY);
+    EXPECT_EQ(firls_sampled(h, 21, 1, points, ones, ones, 2.0), FIR_ESPEC);
+    EXPECT_EQ(firls_sampled(h, 21, 0, points, ones, ones, 2.0), FIR_ESPEC);
+    EXPECT_EQ(firls_sampled(h, 21, 3, pointsBad, ones, ones, 2.0), FIR_EBANDS);
+    EXPECT_EQ(firls_sampled(h, 21, 3, points, ones, ones, 1.0), FIR_EBANDS);
+    EXPECT_EQ(firls_sampled(h, 21, 3, points, ones, weightNegative, 2.0), FIR_EWEIGHTS);
+}
+
+TEST(firwin, kaiser) {
+    // Kaiser's formula: 60 dB and a transition band of 0.05 * fs need 74 taps
+    const int NUMTAPS = 75;
+    const int NUMBANDS = 2;
+    const FirFloat bands[2 * NUMBANDS] = {0, 0.2, 0.25, 0.5};
+    const FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat h[NUMTAPS];
+    EXPECT_EQ(firwin(h, NUMTAPS, NUMBANDS, bands, desired, FIR_WINDOW_KAISER, 60.0, 1.0), 0);
+    for (int i = 0; i < NUMTAPS / 2; i++) {
+        EXPECT_EQ(h[i], h[NUMTAPS - 1 - i]);
+    }
+
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 1.0), 0);
+    EXPECT_NEAR(H[0], 1.0, 1e-12);
+    EXPECT_LT(maxDeviation(F, H, NUMFREQS, 0.0, 0.2, 1.0), 0.0011);
+    EXPECT_LT(maxDeviation(F, H, NUMFREQS, 0.25, 0.5, 0.0), 0.0011);
+    // halfway the transition band (F = 0.225), the gain is approx the mean of both bands
+    EXPECT_NEAR(H[(NUMFREQS - 1) * 9 / 20], 0.5, 0.01);
+}
+
+TEST(firwin, windows) {
+    // high pass and band pass, scaled in the first band with a nonzero gain
+    const int NUMTAPS = 51;
+    const int NUMFREQS = 1001;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    FirFloat h[NUMTAPS];
+    const FirFloat bandsHigh[4] = {0, 0.15, 0.25, 0.5};
+    const FirFloat desiredHigh[2] = {0, 1};
+    const FirFloat bandsPass[6] = {0, 0.1, 0.15, 0.3, 0.35, 0.5};
+    const FirFloat desiredPass[3] = {0, 2, 0};
+    for (int window : {FIR_WINDOW_HANN, FIR_WINDOW_BLACKMAN}) {
+        EXPECT_EQ(firwin(h, NUMTAPS, 2, bandsHigh, desiredHigh, window, 0.0, 1.0), 0);
+        EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 1.0), 0);
+        EXPECT_NEAR(H[NUMFREQS - 1], 1.0, 1e-12);
+        EXPECT_LT(H[0], 1e-3);
+
+        EXPECT_EQ(firwin(h, NUMTAPS, 3, bandsPass, desiredPass, window, 0.0, 1.0), 0);
+        EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 1.0), 0);
+        EXPECT_NEAR(H[450], 2.0, 1e-12);
+        EXPECT_LT(H[0], 2e-3);
+        EXPECT_LT(H[NUMFREQS - 1], 2e-3);
+    }
+
+    EXPECT_EQ(firwin(h, 0, 2, bandsHigh, desiredHigh, FIR_WINDOW_HANN, 0.0, 1.0), FIR_ENUMTAPS);
+    EXPECT_EQ(firwin(h, NUMTAPS, 2, bandsHigh, desiredHigh, FIR_WINDOW_HANN, 0.0, 0.0),
+              FIR_EFREQUENCY);
+    EXPECT_EQ(firwin(h, NUMTAPS, 0, bandsHigh, desiredHigh, FIR_WINDOW_HANN, 0.0, 1.0),
+              FIR_ENUMBANDS);
+    EXPECT_EQ(firwin(h, NUMTAPS, 2, bandsHigh, desiredHigh, FIR_WINDOW_HANN, 0.0, 0.5),
+              FIR_EBANDS);
+    EXPECT_EQ(firwin(h, NUMTAPS, 2, bandsHigh, desiredHigh, 0, 0.0, 1.0), FIR_EWINDOW);
+    EXPECT_EQ(firwin(h, NUMTAPS, 2, bandsHigh, desiredHigh, FIR_WINDOW_KAISER, -1.0, 1.0),
+              FIR_EWINDOW);
+    EXPECT_TRUE(strstr(firerror(FIR_EWINDOW), "window") != NULL);
+}
+
+TEST(firminphase, firminphase) {
+    // a maximum phase filter has the zero mirrored inside the unit circle
+    const FirFloat maximumPhase[2] = {-0.5, 1};
+    FirFloat minimumPhase[2];
+    EXPECT_EQ(firminphase(minimumPhase, 2, maximumPhase, 0), 0);
+    EXPECT_NEAR(minimumPhase[0], 1.0, 1e-9);
+    EXPECT_NEAR(minimumPhase[1], -0.5, 1e-9);
+
+    const int NUMTAPS = 101;
+    const int NUMBANDS = 2;
+    const FirFloat bands[2 * NUMBANDS] = {0, 0.2, 0.25, 0.5};
+    const FirFloat desired[NUMBANDS] = {1, 0};
+    const FirFloat weight[NUMBANDS] = {1, 100};
+    FirFloat h[NUMTAPS];
+    FirFloat hMinimum[NUMTAPS];
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0), 0);
+    EXPECT_EQ(firminphase(hMinimum, NUMTAPS, h, 64), 0);
+
+    // same magnitude response
+    const int NUMFREQS = 4097;
+    static FirFloat F[NUMFREQS];
+    static FirFloat H[NUMFREQS];
+    static FirFloat HMinimum[NUMFREQS];
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 1.0), 0);
+    EXPECT_EQ(firfreqz(F, HMinimum, NUMFREQS, NUMTAPS, hMinimum, 1.0), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        EXPECT_NEAR(HMinimum[i], H[i], 1e-5);
+    }
+
+    // half of the energy in the first 10 taps, instead of around the middle tap
+    FirFloat energy = 0.0;
+    FirFloat energyStart = 0.0;
+    for (int i = 0; i < NUMTAPS; i++) {
+        energy += h[i] * h[i];
+        if (i < 10) {
+            energyStart += hMinimum[i] * hMinimum[i];
+        }
+    }
+    EXPECT_GT(energyStart, 0.5 * energy);
+
+    EXPECT_EQ(firminphase(hMinimum, 0, h, 0), FIR_ENUMTAPS);
+}
+
 TEST(freqz, compare_freqz_naive) {
     // use other test to generate taps
     const int NUMTAPS = 9;
@@ -338,4 +1242,571 @@ TEST(freqz, compare_freqz_naive) {
     }
 }
 
+TEST(freqz, plan) {
+    const int NUMFREQS = 64;
+    FirFloat F[NUMFREQS];
+    FirFloat H[NUMFREQS];
+    FirFloat F2[NUMFREQS];
+    FirFloat H2[NUMFREQS];
+
+    EXPECT_TRUE(firfreqz_plan_create(1) == NULL);
+    FirFreqzPlan *plan = firfreqz_plan_create(NUMFREQS);
+    ASSERT_TRUE(plan != NULL);
+
+    // execute the same plan repeatedly, with different filters
+    for (int numTaps = 1; numTaps < 2 * (NUMFREQS - 1); numTaps += 7) {
+        FirFloat taps[2 * NUMFREQS];
+        for (int i = 0; i < numTaps; i++) {
+            taps[i] = 1.0 / (1 + i);
+        }
+        EXPECT_EQ(firfreqz_plan_execute(plan, F, H, numTaps, taps, 3.0), 0);
+        EXPECT_EQ(firfreqz_naive(F2, H2, NUMFREQS, numTaps, taps, 3.0), 0);
+        for (int i = 0; i < NUMFREQS; i++) {
+            EXPECT_NEAR(F[i], F2[i], 1e-10);
+            EXPECT_NEAR(H[i], H2[i], 1e-10);
+        }
+    }
+
+    // too many taps for the number of frequencies
+    FirFloat taps[2 * NUMFREQS] = {};
+    EXPECT_EQ(firfreqz_plan_execute(plan, F, H, 2 * (NUMFREQS - 1), taps, 1.0), -1);
+    EXPECT_EQ(firfreqz_plan_execute(plan, F, H, 10, taps, 0.0), -1);
+    firfreqz_plan_destroy(plan);
+}
+
+TEST(freqz, symmetric) {
+    // symmetric taps use the half size FFT when the number of points - 1 is even
+    const int MAXFREQS = 66;
+    FirFloat F[MAXFREQS];
+    FirFloat H[MAXFREQS];
+    FirFloat F2[MAXFREQS];
+    FirFloat H2[MAXFREQS];
+    FirFloat HdB[MAXFREQS];
+
+    for (int numFreqs = 2; numFreqs <= MAXFREQS; numFreqs += 3) {
+        for (int numTaps = 1; numTaps < 2 * (numFreqs - 1); numTaps++) {
+            FirFloat taps[2 * MAXFREQS];
+            for (int i = 0; i < (numTaps + 1) / 2; i++) {
+                taps[i] = taps[numTaps - 1 - i] = std::cos(0.7 * i) / (1 + i);
+            }
+            EXPECT_EQ(firfreqz(F, H, numFreqs, numTaps, taps, 3.0), 0);
+            EXPECT_EQ(firfreqz_naive(F2, H2, numFreqs, numTaps, taps, 3.0), 0);
+            for (int i = 0; i < numFreqs; i++) {
+                EXPECT_NEAR(F[i], F2[i], 1e-10);
+                EXPECT_NEAR(H[i], H2[i], 1e-10);
+            }
+        }
+    }
+
+    // designed filter, type I and type II, in dB
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0, 0.3, 0.4, 1};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    for (int numTaps = 30; numTaps <= 31; numTaps++) {
+        FirFloat h[31];
+        EXPECT_EQ(firls(h, numTaps, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+        FirFreqzPlan *plan = firfreqz_plan_create(MAXFREQS - 1);
+        ASSERT_TRUE(plan != NULL);
+        EXPECT_EQ(firfreqz_plan_response(plan, F, NULL, NULL, HdB, NULL, NULL, numTaps, h, 2.0,
+                                         FIR_FREQZ_DB),
+                  0);
+        firfreqz_plan_destroy(plan);
+        EXPECT_EQ(firfreqz_naive(F2, H2, MAXFREQS - 1, numTaps, h, 2.0), 0);
+        for (int i = 0; i < MAXFREQS - 1; i++) {
+            // type II has an exact zero at Nyquist, the naive sum only approximates it
+            if (H2[i] > 1e-10) {
+                EXPECT_NEAR(HdB[i], 20.0 * std::log10(H2[i]), 1e-6);
+            } else {
+                EXPECT_LT(HdB[i], -190.0);
+            }
+        }
+    }
+}
+
+TEST(freqz, complex_phase_delay) {
+    const int NUMTAPS = 9;
+    FirFloat h[NUMTAPS] = {0.1, -0.2, 0.3, 0.7, 1.0, 0.5, -0.4, 0.2, 0.05};
+
+    const int NUMFREQS = 33;
+    FirFloat F[NUMFREQS];
+    FirFloat re[NUMFREQS];
+    FirFloat im[NUMFREQS];
+    FirFloat H[NUMFREQS];
+    FirFloat HdB[NUMFREQS];
+    FirFloat phases[NUMFREQS];
+    FirFloat delays[NUMFREQS];
+    EXPECT_EQ(firfreqz_complex(F, re, im, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    EXPECT_EQ(firfreqz_phase(F, HdB, phases, NUMFREQS, NUMTAPS, h, 2.0, FIR_FREQZ_DB), 0);
+    EXPECT_EQ(firgrpdelay(F, delays, NUMFREQS, NUMTAPS, h, 2.0), 0);
+
+    // compare with direct evaluation of H(ω) = Σ h[k] exp(-jωk) and its derivative
+    FirFloat previousPhase = 0.0;
+    for (int i = 0; i < NUMFREQS; i++) {
+        FirFloat w = M_PI * i / (NUMFREQS - 1);
+        std::complex<FirFloat> response;
+        std::complex<FirFloat> ramp;
+        for (int k = 0; k < NUMTAPS; k++) {
+            response += h[k] * std::exp(std::complex<FirFloat>(0, -w * k));
+            ramp += (FirFloat)k * h[k] * std::exp(std::complex<FirFloat>(0, -w * k));
+        }
+        EXPECT_NEAR(re[i], response.real(), 1e-10);
+        EXPECT_NEAR(im[i], response.imag(), 1e-10);
+        EXPECT_NEAR(HdB[i], 20 * log10(H[i]), 1e-10);
+        EXPECT_NEAR(delays[i], (ramp / response).real(), 1e-8);
+
+        // unwrapped phase: equal modulo 2π, and no jumps
+        FirFloat difference = phases[i] - std::arg(response);
+        EXPECT_NEAR(remainder(difference, 2 * M_PI), 0.0, 1e-10);
+        if (i > 0) {
+            EXPECT_LT(fabs(phases[i] - previousPhase), M_PI);
+        }
+        previousPhase = phases[i];
+    }
+}
+
+TEST(freqz, delay_linear_phase) {
+    // linear phase filter: constant group delay (N - 1) / 2, linear phase in the pass band
+    const int NUMTAPS = 31;
+    const int NUMBANDS = 2;
+
+    FirFloat bands[2 * NUMBANDS] = {0, 0.3, 0.4, 1};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    FirFloat h[NUMTAPS];
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+
+    const int NUMFREQS = 101;
+    FirFloat F[NUMFREQS];
+    FirFloat H[NUMFREQS];
+    FirFloat phases[NUMFREQS];
+    FirFloat delays[NUMFREQS];
+    FirFreqzPlan *plan = firfreqz_plan_create(NUMFREQS);
+    EXPECT_EQ(firfreqz_plan_response(plan, F, NULL, NULL, H, phases, delays, NUMTAPS, h, 2.0, 0),
+              0);
+    firfreqz_plan_destroy(plan);
+    for (int i = 0; i < NUMFREQS; i++) {
+        if (F[i] < 0.3) {
+            EXPECT_NEAR(delays[i], 15.0, 1e-8);
+            EXPECT_NEAR(phases[i], -15.0 * M_PI * F[i], 1e-8);
+        }
+    }
+}
+
+TEST(freqz, zoom_and_points) {
+    const int NUMTAPS = 101;
+    const int NUMBANDS = 2;
+
+    FirFloat bands[2 * NUMBANDS] = {0, 0.3, 0.4, 1};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    FirFloat h[NUMTAPS];
+    EXPECT_EQ(firls(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 2.0), 0);
+
+    // full range: same as firfreqz
+    const int NUMFREQS = 257;
+    FirFloat F[NUMFREQS];
+    FirFloat H[NUMFREQS];
+    FirFloat F2[NUMFREQS];
+    FirFloat H2[NUMFREQS];
+    FirFloat H3[NUMFREQS];
+    EXPECT_EQ(firfreqz(F, H, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    EXPECT_EQ(firfreqz_zoom(F2, H2, NUMFREQS, 0.0, 1.0, NUMTAPS, h, 2.0), 0);
+    EXPECT_EQ(firfreqz_points(F, H3, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        EXPECT_NEAR(F[i], F2[i], 1e-12);
+        EXPECT_NEAR(H[i], H2[i], 1e-10);
+        EXPECT_NEAR(H[i], H3[i], 1e-10);
+    }
+
+    // zoom in the pass band, compare with the naive sum
+    EXPECT_EQ(firfreqz_zoom(F2, H2, NUMFREQS, 0.01, 0.05, NUMTAPS, h, 2.0), 0);
+    EXPECT_EQ(firfreqz_points(F2, H3, NUMFREQS, NUMTAPS, h, 2.0), 0);
+    for (int i = 0; i < NUMFREQS; i++) {
+        EXPECT_NEAR(F2[i], 0.01 + 0.04 * i / (NUMFREQS - 1), 1e-12);
+        std::complex<FirFloat> response;
+        for (int k = 0; k < NUMTAPS; k++) {
+            response += h[k] * std::exp(std::complex<FirFloat>(0, -M_PI * F2[i] * k));
+        }
+        EXPECT_NEAR(H2[i], std::abs(response), 1e-10);
+        EXPECT_NEAR(H3[i], std::abs(response), 1e-10);
+    }
+
+    // frequencies close to DC and Nyquist
+    FirFloat F_edges[4] = {1e-9, 1e-6, 1.0 - 1e-6, 1.0 - 1e-9};
+    FirFloat H_edges[4];
+    EXPECT_EQ(firfreqz_points(F_edges, H_edges, 4, NUMTAPS, h, 2.0), 0);
+    EXPECT_NEAR(H_edges[0], H[0], 1e-10);
+    EXPECT_NEAR(H_edges[1], H[0], 1e-10);
+    EXPECT_NEAR(H_edges[2], H[NUMFREQS - 1], 1e-10);
+    EXPECT_NEAR(H_edges[3], H[NUMFREQS - 1], 1e-10);
+
+    // bad frequency range
+    EXPECT_EQ(firfreqz_zoom(F2, H2, NUMFREQS, 0.5, 0.4, NUMTAPS, h, 2.0), -1);
+    EXPECT_EQ(firfreqz_zoom(F2, H2, NUMFREQS, 0.5, 1.1, NUMTAPS, h, 2.0), -1);
+}
+
+// direct convolution of the complete signal, zero initial state
+static std::vector<FirFloat> convolve(const std::vector<FirFloat> &taps,
+                                      const std::vector<FirFloat> &x) {
+    std::vector<FirFloat> y(x.size(), 0.0);
+    for (size_t i = 0; i < x.size(); i++) {
+        for (size_t k = 0; k < taps.size() && k <= i; k++) {
+            y[i] += taps[k] * x[i - k];
+        }
+    }
+    return y;
+}
+
+// deterministic test signal
+static std::vector<FirFloat> testSignal(int n) {
+    std::vector<FirFloat> x((size_t)n);
+    for (int i = 0; i < n; i++) {
+        x[(size_t)i] = std::sin(0.1 * i) + 0.5 * std::cos(2.3 * i + 0.2 * i * i / n);
+    }
+    return x;
+}
+
+TEST(filter, stream) {
+    const int NUMSAMPLES = 1500;
+    const std::vector<FirFloat> x = testSignal(NUMSAMPLES);
+    const int BLOCKSIZES[] = {1, 7, 256, 300, NUMSAMPLES};
+
+    for (int numTaps : {1, 2, 5, 6, 33, 300, 301}) {
+        for (bool symmetric : {false, true}) {
+            std::vector<FirFloat> taps((size_t)numTaps);
+            for (int i = 0; i < numTaps; i++) {
+                int j = symmetric ? std::min(i, numTaps - 1 - i) : i;
+                taps[(size_t)i] = std::cos(0.3 * j) / (1 + j);
+            }
+            const std::vector<FirFloat> expected = convolve(taps, x);
+
+            FirFilter *filter = firfilter_create(numTaps, taps.data());
+            ASSERT_TRUE(filter != NULL);
+            for (int blockSize : BLOCKSIZES) {
+                // in place, in blocks of blockSize samples
+                std::vector<FirFloat> y = x;
+                for (int start = 0; start < NUMSAMPLES; start += blockSize) {
+                    int n = std::min(blockSize, NUMSAMPLES - start);
+                    EXPECT_EQ(firfilter_process(filter, &y[(size_t)start], &y[(size_t)start], n),
+                              0);
+                }
+                for (int i = 0; i < NUMSAMPLES; i++) {
+                    EXPECT_NEAR(y[(size_t)i], expected[(size_t)i], 1e-12);
+                }
+                firfilter_reset(filter);
+            }
+            firfilter_destroy(filter);
+        }
+    }
+
+    FirFloat tap = 1.0;
+    EXPECT_TRUE(firfilter_create(0, &tap) == NULL);
+    EXPECT_EQ(firfilter_process(NULL, &tap, &tap, 1), -1);
+    firfilter_destroy(NULL);
+}
+
+TEST(filter, overlap_save) {
+    const int NUMSAMPLES = 3000;
+    const std::vector<FirFloat> x = testSignal(NUMSAMPLES);
+
+    for (int numTaps : {1, 20, 301}) {
+        std::vector<FirFloat> taps((size_t)numTaps);
+        for (int i = 0; i < numTaps; i++) {
+            taps[(size_t)i] = std::cos(0.3 * i) / (1 + i);
+        }
+        const std::vector<FirFloat> expected = convolve(taps, x);
+
+        for (int blockSize : {1, 64, 500}) {
+            FirFilter *filter =
+                firfilter_create_method(numTaps, taps.data(), FIR_FILTER_FFT, blockSize);
+            ASSERT_TRUE(filter != NULL);
+            EXPECT_EQ(firfilter_method(filter), FIR_FILTER_FFT);
+            EXPECT_EQ(firfilter_latency(filter), blockSize);
+            for (int pass = 0; pass < 2; pass++) {
+                // in place, with call sizes unrelated to the block size
+                std::vector<FirFloat> y = x;
+                for (int start = 0; start < NUMSAMPLES; start += 77) {
+                    int n = std::min(77, NUMSAMPLES - start);
+                    EXPECT_EQ(firfilter_process(filter, &y[(size_t)start], &y[(size_t)start], n),
+                              0);
+                }
+                for (int i = 0; i < NUMSAMPLES; i++) {
+                    FirFloat delayed = (i >= blockSize) ? expected[(size_t)(i - blockSize)] : 0.0;
+                    EXPECT_NEAR(y[(size_t)i], delayed, 1e-12);
+                }
+                firfilter_reset(filter);
+            }
+            firfilter_destroy(filter);
+        }
+    }
+
+    // automatic selection: direct form for short filters or without latency
+    std::vector<FirFloat> taps(4001, 0.5);
+    FirFilter *filter = firfilter_create_method(5, taps.data(), FIR_FILTER_AUTO, 1024);
+    EXPECT_EQ(firfilter_method(filter), FIR_FILTER_DIRECT);
+    EXPECT_EQ(firfilter_latency(filter), 0);
+    firfilter_destroy(filter);
+    filter = firfilter_create_method(4001, taps.data(), FIR_FILTER_AUTO, 0);
+    EXPECT_EQ(firfilter_method(filter), FIR_FILTER_DIRECT);
+    firfilter_destroy(filter);
+    filter = firfilter_create_method(600, taps.data(), FIR_FILTER_AUTO, 1024);
+    EXPECT_EQ(firfilter_method(filter), FIR_FILTER_FFT);
+    EXPECT_EQ(firfilter_latency(filter), 1024);
+    firfilter_destroy(filter);
+    // filter much longer than the latency: partitioned
+    filter = firfilter_create_method(4001, taps.data(), FIR_FILTER_AUTO, 1024);
+    EXPECT_EQ(firfilter_method(filter), FIR_FILTER_PARTITIONED);
+    EXPECT_EQ(firfilter_latency(filter), 1024);
+    firfilter_destroy(filter);
+
+    EXPECT_TRUE(firfilter_create_method(5, taps.data(), FIR_FILTER_FFT, 0) == NULL);
+    EXPECT_TRUE(firfilter_create_method(5, taps.data(), 99, 64) == NULL);
+    EXPECT_EQ(firfilter_method(NULL), -1);
+    EXPECT_EQ(firfilter_latency(NULL), -1);
+}
+
+TEST(filter, partitioned) {
+    const int NUMSAMPLES = 3000;
+    const std::vector<FirFloat> x = testSignal(NUMSAMPLES);
+
+    for (int numTaps : {1, 64, 65, 1001}) {
+        std::vector<FirFloat> taps((size_t)numTaps);
+        for (int i = 0; i < numTaps; i++) {
+            taps[(size_t)i] = std::cos(0.3 * i) / (1 + i);
+        }
+        const std::vector<FirFloat> expected = convolve(taps, x);
+
+        for (int blockSize : {1, 16, 64}) {
+            FirFilter *filter =
+                firfilter_create_method(numTaps, taps.data(), FIR_FILTER_PARTITIONED, blockSize);
+            ASSERT_TRUE(filter != NULL);
+            EXPECT_EQ(firfilter_method(filter), FIR_FILTER_PARTITIONED);
+            EXPECT_EQ(firfilter_latency(filter), blockSize);
+            for (int pass = 0; pass < 2; pass++) {
+                std::vector<FirFloat> y((size_t)NUMSAMPLES);
+                for (int start = 0; start < NUMSAMPLES; start += 77) {
+                    int n = std::min(77, NUMSAMPLES - start);
+                    EXPECT_EQ(firfilter_process(filter, &x[(size_t)start], &y[(size_t)start], n),
+                              0);
+                }
+                for (int i = 0; i < NUMSAMPLES; i++) {
+                    FirFloat delayed = (i >= blockSize) ? expected[(size_t)(i - blockSize)] : 0.0;
+                    EXPECT_NEAR(y[(size_t)i], delayed, 1e-12);
+                }
+                firfilter_reset(filter);
+            }
+            firfilter_destroy(filter);
+        }
+    }
+    FirFloat tap = 1.0;
+    EXPECT_TRUE(firfilter_create_method(1, &tap, FIR_FILTER_PARTITIONED, 0) == NULL);
+}
+
+TEST(filter, single_precision) {
+    const int NUMSAMPLES = 3000;
+    const int NUMTAPS = 301;
+    const std::vector<FirFloat> x = testSignal(NUMSAMPLES);
+    std::vector<FirFloat> taps((size_t)NUMTAPS);
+    for (int i = 0; i < NUMTAPS; i++) {
+        taps[(size_t)i] = std::cos(0.3 * i) / (1 + i);
+    }
+    const std::vector<FirFloat> expected = convolve(taps, x);
+    const std::vector<float> x_f(x.begin(), x.end());
+    const std::vector<float> taps_f(taps.begin(), taps.end());
+
+    // odd block size: the partitioned FFT length is not a multiple of 4
+    for (int method : {FIR_FILTER_DIRECT, FIR_FILTER_FFT, FIR_FILTER_PARTITIONED}) {
+        for (int blockSize : {64, 75}) {
+            FirFilterF *filter =
+                firfilter_create_method_f(NUMTAPS, taps_f.data(), method, blockSize);
+            ASSERT_TRUE(filter != NULL);
+            EXPECT_EQ(firfilter_method_f(filter), method);
+            const int latency = firfilter_latency_f(filter);
+            for (int pass = 0; pass < 2; pass++) {
+                std::vector<float> y((size_t)NUMSAMPLES);
+                for (int start = 0; start < NUMSAMPLES; start += 77) {
+                    int n = std::min(77, NUMSAMPLES - start);
+                    EXPECT_EQ(
+                        firfilter_process_f(filter, &x_f[(size_t)start], &y[(size_t)start], n), 0);
+                }
+                for (int i = 0; i < NUMSAMPLES; i++) {
+                    FirFloat delayed = (i >= latency) ? expected[(size_t)(i - latency)] : 0.0;
+                    EXPECT_NEAR(y[(size_t)i], delayed, 1e-5) << method << " " << blockSize;
+                }
+                firfilter_reset_f(filter);
+            }
+            firfilter_destroy_f(filter);
+        }
+    }
+
+    float tap = 1.0f;
+    EXPECT_TRUE(firfilter_create_f(0, &tap) == NULL);
+    EXPECT_EQ(firfilter_process_f(NULL, &tap, &tap, 1), -1);
+    EXPECT_EQ(firfilter_method_f(NULL), -1);
+    firfilter_destroy_f(NULL);
+}
+
+TEST(filter, multichannel) {
+    const int NUMSAMPLES = 1500;
+    const int NUMCHANNELS = 3;
+    const int BLOCKSIZES[] = {1, 7, 700, NUMSAMPLES};
+
+    // channel c is the test signal scaled with c + 1, with a different sign per channel
+    std::vector<std::vector<FirFloat>> x;
+    for (int c = 0; c < NUMCHANNELS; c++) {
+        x.push_back(testSignal(NUMSAMPLES));
+        for (FirFloat &value : x.back()) {
+            value *= (c % 2 ? -1 : 1) * (c + 1);
+        }
+    }
+
+    for (int numTaps : {1, 6, 33, 301}) {
+        for (bool symmetric : {false, true}) {
+            std::vector<FirFloat> taps((size_t)numTaps);
+            for (int i = 0; i < numTaps; i++) {
+                int j = symmetric ? std::min(i, numTaps - 1 - i) : i;
+                taps[(size_t)i] = std::cos(0.3 * j) / (1 + j);
+            }
+            std::vector<std::vector<FirFloat>> expected;
+            for (int c = 0; c < NUMCHANNELS; c++) {
+                expected.push_back(convolve(taps, x[(size_t)c]));
+            }
+
+            for (int layout : {FIR_LAYOUT_INTERLEAVED, FIR_LAYOUT_PLANAR}) {
+                FirFilterMulti *filter =
+                    firfilter_multi_create(NUMCHANNELS, numTaps, taps.data(), layout);
+                ASSERT_TRUE(filter != NULL);
+                for (int blockSize : BLOCKSIZES) {
+                    // in place, in blocks of blockSize samples per channel
+                    std::vector<FirFloat> y((size_t)(NUMSAMPLES * NUMCHANNELS));
+                    for (int start = 0; start < NUMSAMPLES; start += blockSize) {
+                        int n = std::min(blockSize, NUMSAMPLES - start);
+                        FirFloat *block = &y[(size_t)(start * NUMCHANNELS)];
+                        for (int i = 0; i < n; i++) {
+                            for (int c = 0; c < NUMCHANNELS; c++) {
+                                int k = (layout == FIR_LAYOUT_INTERLEAVED) ? i * NUMCHANNELS + c
+                                                                           : c * n + i;
+                                block[k] = x[(size_t)c][(size_t)(start + i)];
+                            }
+                        }
+                        EXPECT_EQ(firfilter_multi_process(filter, block, block, n), 0);
+                        for (int i = 0; i < n; i++) {
+                            for (int c = 0; c < NUMCHANNELS; c++) {
+                                int k = (layout == FIR_LAYOUT_INTERLEAVED) ? i * NUMCHANNELS + c
+                                                                           : c * n + i;
+                                EXPECT_NEAR(block[k], expected[(size_t)c][(size_t)(start + i)],
+                                            1e-12);
+                            }
+                        }
+                    }
+                    firfilter_multi_reset(filter);
+                }
+                firfilter_multi_destroy(filter);
+            }
+        }
+    }
+
+    FirFloat tap = 1.0;
+    EXPECT_TRUE(firfilter_multi_create(0, 1, &tap, FIR_LAYOUT_PLANAR) == NULL);
+    EXPECT_TRUE(firfilter_multi_create(2, 0, &tap, FIR_LAYOUT_PLANAR) == NULL);
+    EXPECT_TRUE(firfilter_multi_create(2, 1, &tap, 99) == NULL);
+    EXPECT_EQ(firfilter_multi_process(NULL, &tap, &tap, 1), -1);
+    firfilter_multi_destroy(NULL);
+}
+
+// reference: upsample by zero insertion, filter, downsample
+static std::vector<FirFloat> upfirdn(const std::vector<FirFloat> &taps,
+                                     const std::vector<FirFloat> &x, int L, int M) {
+    std::vector<FirFloat> up(x.size() * (size_t)L, 0.0);
+    for (size_t i = 0; i < x.size(); i++) {
+        up[i * (size_t)L] = x[i];
+    }
+    std::vector<FirFloat> filtered = convolve(taps, up);
+    std::vector<FirFloat> y;
+    for (size_t i = 0; i < filtered.size(); i += (size_t)M) {
+        y.push_back(filtered[i]);
+    }
+    return y;
+}
+
+TEST(resampler, upfirdn) {
+    const int NUMSAMPLES = 2500;
+    const std::vector<FirFloat> x = testSignal(NUMSAMPLES);
+    const int FACTORS[][2] = {{1, 1}, {1, 3}, {4, 1}, {3, 2}, {2, 3}, {5, 7}};
+
+    for (int numTaps : {1, 10, 61}) {
+        std::vector<FirFloat> taps((size_t)numTaps);
+        for (int i = 0; i < numTaps; i++) {
+            taps[(size_t)i] = std::cos(0.3 * i) / (1 + i);
+        }
+        for (const auto &factor : FACTORS) {
+            const int L = factor[0];
+            const int M = factor[1];
+            const std::vector<FirFloat> expected = upfirdn(taps, x, L, M);
+
+            FirResampler *resampler = firresampler_create(L, M, numTaps, taps.data());
+            ASSERT_TRUE(resampler != NULL);
+            for (int blockSize : {1, 13, 1500}) {
+                std::vector<FirFloat> y;
+                for (int start = 0; start < NUMSAMPLES; start += blockSize) {
+                    int n = std::min(blockSize, NUMSAMPLES - start);
+                    int maxOutput = (n * L + M - 1) / M;
+                    std::vector<FirFloat> block((size_t)maxOutput);
+                    int numOutput =
+                        firresampler_process(resampler, &x[(size_t)start], n, block.data());
+                    EXPECT_GE(numOutput, 0);
+                    EXPECT_LE(numOutput, maxOutput);
+                    y.insert(y.end(), block.begin(), block.begin() + numOutput);
+                }
+                ASSERT_EQ(y.size(), expected.size());
+                for (size_t i = 0; i < y.size(); i++) {
+                    EXPECT_NEAR(y[i], expected[i], 1e-12);
+                }
+                firresampler_reset(resampler);
+            }
+            firresampler_destroy(resampler);
+        }
+    }
+
+    FirFloat tap = 1.0;
+    EXPECT_TRUE(firresampler_create(0, 1, 1, &tap) == NULL);
+    EXPECT_TRUE(firresampler_create(1, 0, 1, &tap) == NULL);
+    EXPECT_TRUE(firresampler_create(1, 1, 0, &tap) == NULL);
+    EXPECT_EQ(firresampler_process(NULL, &tap, 1, &tap), -1);
+    firresampler_destroy(NULL);
+}
+
+TEST(resampler, single_precision) {
+    const int NUMSAMPLES = 2500;
+    const int NUMTAPS = 61;
+    const int L = 3;
+    const int M = 2;
+    const std::vector<FirFloat> x = testSignal(NUMSAMPLES);
+    std::vector<FirFloat> taps((size_t)NUMTAPS);
+    for (int i = 0; i < NUMTAPS; i++) {
+        taps[(size_t)i] = std::cos(0.3 * i) / (1 + i);
+    }
+    const std::vector<FirFloat> expected = upfirdn(taps, x, L, M);
+    const std::vector<float> x_f(x.begin(), x.end());
+    const std::vector<float> taps_f(taps.begin(), taps.end());
+
+    FirResamplerF *resampler = firresampler_create_f(L, M, NUMTAPS, taps_f.data());
+    ASSERT_TRUE(resampler != NULL);
+    std::vector<float> y((size_t)(NUMSAMPLES * L + M - 1) / M);
+    ASSERT_EQ(firresampler_process_f(resampler, x_f.data(), NUMSAMPLES, y.data()),
+              (int)expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_NEAR(y[i], expected[i], 1e-5);
+    }
+    firresampler_reset_f(resampler);
+    firresampler_destroy_f(resampler);
+
+    float tap = 1.0f;
+    EXPECT_TRUE(firresampler_create_f(0, 1, 1, &tap) == NULL);
+    EXPECT_EQ(firresampler_process_f(NULL, &tap, 1, &tap), -1);
+    firresampler_destroy_f(NULL);
+}
+
 } // namespace
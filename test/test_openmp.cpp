@@ -0,0 +1,74 @@
+/*
+ * Test cases for the OpenMP code of firls, linked with a library built with
+ * FIR_OPENMP.
+ */
+
+#include "fir.hpp"
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(openmp, lu_matches_single_thread) {
+    // narrow transition band: LDLT with one thread, parallel LU with more
+    const int NUMTAPS = 601;
+    const int NUMBANDS = 2;
+    FirFloat bands[2 * NUMBANDS] = {0.0, 0.2, 0.214, 0.5};
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    static FirFloat h[NUMTAPS];
+    static FirFloat hThreads[NUMTAPS];
+    FirlsStats stats;
+
+    EXPECT_EQ(firls_set_num_threads(1), 1);
+    EXPECT_EQ(firls_stats(h, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0, &stats), 0);
+    EXPECT_EQ(stats.solver, FIR_SOLVER_LDLT);
+
+    for (int numThreads = 2; numThreads <= 4; numThreads++) {
+        EXPECT_EQ(firls_set_num_threads(numThreads), numThreads);
+        EXPECT_EQ(firls_stats(hThreads, NUMTAPS, NUMBANDS, bands, desired, desired, weight, 1.0,
+                              &stats),
+                  0);
+        EXPECT_EQ(stats.solver, FIR_SOLVER_LU);
+        for (int i = 0; i < NUMTAPS; i++) {
+            EXPECT_NEAR(hThreads[i], h[i], 1e-6);
+        }
+    }
+    firls_set_num_threads(1);
+}
+
+TEST(openmp, batch_single_threaded) {
+    // the batch workers ignore firls_set_num_threads: LDLT, as with one thread
+    const int NUMTAPS = 601;
+    const int NUMBANDS = 2;
+    const int NUMFILTERS = 4;
+    FirFloat bands[NUMFILTERS][2 * NUMBANDS];
+    FirFloat desired[NUMBANDS] = {1, 0};
+    FirFloat weight[NUMBANDS] = {1, 1};
+    FirlsSpec specs[NUMFILTERS];
+    for (int i = 0; i < NUMFILTERS; i++) {
+        FirFloat cutoff = 0.1 + 0.05 * i;
+        bands[i][0] = 0.0;
+        bands[i][1] = cutoff;
+        bands[i][2] = cutoff + 0.014;
+        bands[i][3] = 0.5;
+        specs[i] = {NUMBANDS, bands[i], desired, desired, weight, 1.0};
+    }
+
+    static FirFloat h[NUMFILTERS * NUMTAPS];
+    static FirFloat hSingle[NUMTAPS];
+    FirlsStats stats;
+    EXPECT_EQ(firls_set_num_threads(4), 4);
+    EXPECT_EQ(firls_batch(h, NUMFILTERS, NUMTAPS, specs, NULL, 2), 0);
+    firls_set_num_threads(1);
+    for (int i = 0; i < NUMFILTERS; i++) {
+        EXPECT_EQ(firls_stats(hSingle, NUMTAPS, NUMBANDS, bands[i], desired, desired, weight, 1.0,
+                              &stats),
+                  0);
+        EXPECT_EQ(stats.solver, FIR_SOLVER_LDLT);
+        for (int j = 0; j < NUMTAPS; j++) {
+            EXPECT_EQ(h[i * NUMTAPS + j], hSingle[j]);
+        }
+    }
+}
+
+} // namespace